@@ -0,0 +1,1179 @@
+#include "aggregate_functions.hpp"
+#include "duckdb/common/bit_utils.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace duckdb {
+
+//! Parameters of the aggregates, resolved in bind. Every aggregate binds this, so the -If variants can keep the
+//! update of the aggregate they wrap next to its parameters.
+struct ChAggregateBindData : FunctionData {
+	//! quantileTDigest: the quantile level
+	double level = 0.5;
+	//! topK: the number of values returned
+	idx_t k = 10;
+	aggregate_update_t wrappedUpdate = nullptr;
+	aggregate_simple_update_t wrappedSimpleUpdate = nullptr;
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<ChAggregateBindData>(*this);
+	}
+	bool Equals(const FunctionData &other_p) const override {
+		const auto &other = other_p.Cast<ChAggregateBindData>();
+		return level == other.level && k == other.k && wrappedUpdate == other.wrappedUpdate &&
+		       wrappedSimpleUpdate == other.wrappedSimpleUpdate;
+	}
+};
+
+static unique_ptr<FunctionData> BindAggregate(ClientContext &context, AggregateFunction &function,
+                                              vector<unique_ptr<Expression>> &arguments) {
+	return make_uniq<ChAggregateBindData>();
+}
+
+//! Evaluates a constant parameter and removes it from the arguments, the update only sees the aggregated columns
+static Value BindConstantParameter(ClientContext &context, AggregateFunction &function,
+                                   vector<unique_ptr<Expression>> &arguments, idx_t idx) {
+	if (!arguments[idx]->IsFoldable()) {
+		throw BinderException("%s: parameter %llu must be a constant", function.name, idx + 1);
+	}
+	auto value = ExpressionExecutor::EvaluateScalar(context, *arguments[idx]);
+	if (value.IsNull()) {
+		throw BinderException("%s: parameter %llu must not be NULL", function.name, idx + 1);
+	}
+	Function::EraseArgument(function, arguments, idx);
+	return value;
+}
+
+//! Calls OP::Add for every row with a non-NULL input
+template <class STATE, class INPUT, class OP>
+static void RowScatterUpdate(Vector inputs[], AggregateInputData &aggr, idx_t input_count, Vector &states,
+                             idx_t count) {
+	UnifiedVectorFormat input_format;
+	UnifiedVectorFormat state_format;
+	inputs[0].ToUnifiedFormat(count, input_format);
+	states.ToUnifiedFormat(count, state_format);
+	const auto values = UnifiedVectorFormat::GetData<INPUT>(input_format);
+	const auto state_data = UnifiedVectorFormat::GetData<STATE *>(state_format);
+	for (idx_t i = 0; i < count; i++) {
+		const auto idx = input_format.sel->get_index(i);
+		if (input_format.validity.RowIsValid(idx)) {
+			OP::Add(*state_data[state_format.sel->get_index(i)], values[idx], aggr);
+		}
+	}
+}
+
+template <class STATE, class INPUT, class OP>
+static void RowSimpleUpdate(Vector inputs[], AggregateInputData &aggr, idx_t input_count, data_ptr_t state_p,
+                            idx_t count) {
+	auto &state = *reinterpret_cast<STATE *>(state_p);
+	UnifiedVectorFormat input_format;
+	inputs[0].ToUnifiedFormat(count, input_format);
+	const auto values = UnifiedVectorFormat::GetData<INPUT>(input_format);
+	for (idx_t i = 0; i < count; i++) {
+		const auto idx = input_format.sel->get_index(i);
+		if (input_format.validity.RowIsValid(idx)) {
+			OP::Add(state, values[idx], aggr);
+		}
+	}
+}
+
+//! How the typed aggregates keep values in their states: fixed-size values as they are, strings copied out of
+//! the vector they came from
+template <class T>
+struct StoredValue {
+	using TYPE = T;
+	static TYPE Store(const T &value) {
+		return value;
+	}
+	static T View(const TYPE &value) {
+		return value;
+	}
+	static T Load(Vector &result, const TYPE &value) {
+		return value;
+	}
+	static hash_t HashOf(const TYPE &value) {
+		return Hash<T>(value);
+	}
+};
+
+template <>
+struct StoredValue<string_t> {
+	using TYPE = string;
+	static TYPE Store(const string_t &value) {
+		return value.GetString();
+	}
+	static string_t View(const TYPE &value) {
+		return string_t(value.c_str(), UnsafeNumericCast<uint32_t>(value.size()));
+	}
+	static string_t Load(Vector &result, const TYPE &value) {
+		return StringVector::AddStringOrBlob(result, value);
+	}
+	static hash_t HashOf(const TYPE &value) {
+		return Hash(value.c_str(), value.size());
+	}
+};
+
+//! Instantiates CALLBACKS<T> for the physical type of the column a typed aggregate keeps values of
+template <template <class> class CALLBACKS>
+static void SetTypedCallbacks(AggregateFunction &function, const LogicalType &type) {
+	switch (type.InternalType()) {
+	case PhysicalType::BOOL:
+		CALLBACKS<bool>::Set(function);
+		break;
+	case PhysicalType::INT8:
+		CALLBACKS<int8_t>::Set(function);
+		break;
+	case PhysicalType::INT16:
+		CALLBACKS<int16_t>::Set(function);
+		break;
+	case PhysicalType::INT32:
+		CALLBACKS<int32_t>::Set(function);
+		break;
+	case PhysicalType::INT64:
+		CALLBACKS<int64_t>::Set(function);
+		break;
+	case PhysicalType::UINT8:
+		CALLBACKS<uint8_t>::Set(function);
+		break;
+	case PhysicalType::UINT16:
+		CALLBACKS<uint16_t>::Set(function);
+		break;
+	case PhysicalType::UINT32:
+		CALLBACKS<uint32_t>::Set(function);
+		break;
+	case PhysicalType::UINT64:
+		CALLBACKS<uint64_t>::Set(function);
+		break;
+	case PhysicalType::INT128:
+		CALLBACKS<hugeint_t>::Set(function);
+		break;
+	case PhysicalType::FLOAT:
+		CALLBACKS<float>::Set(function);
+		break;
+	case PhysicalType::DOUBLE:
+		CALLBACKS<double>::Set(function);
+		break;
+	case PhysicalType::VARCHAR:
+		CALLBACKS<string_t>::Set(function);
+		break;
+	default:
+		throw BinderException("%s: unsupported argument type %s", function.name, type.ToString());
+	}
+}
+
+//! Appends the raw bytes of a value to a serialized state
+template <class T>
+static void WriteRaw(string &out, const T &value) {
+	out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+//! Reads the fields of a serialized state, rejecting truncated or foreign states
+struct StateReader {
+	StateReader(const string_t &blob, const char *function_p)
+	    : data(const_data_ptr_cast(blob.GetData())), size(blob.GetSize()), function(function_p) {
+	}
+
+	template <class T>
+	T Read() {
+		if (pos + sizeof(T) > size) {
+			throw InvalidInputException("%s: invalid aggregate state", function);
+		}
+		T value;
+		memcpy(&value, data + pos, sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+	void Expect(uint8_t tag) {
+		if (Read<uint8_t>() != tag) {
+			throw InvalidInputException("%s: invalid aggregate state", function);
+		}
+	}
+
+	const_data_ptr_t data;
+	idx_t size;
+	idx_t pos = 0;
+	const char *function;
+};
+
+//===--------------------------------------------------------------------===//
+// uniq, uniqCombined
+//===--------------------------------------------------------------------===//
+
+//! HyperLogLog with 2^P one-byte registers behind an exact set of the first SMALL_SET hashes: small groups cost
+//! no registers and are counted exactly. The registers are allocated once the small set overflows.
+template <uint8_t P>
+struct UniqState {
+	static constexpr idx_t REGISTERS = idx_t(1) << P;
+	static constexpr idx_t SMALL_SET = 16;
+	static constexpr uint8_t TAG = 'U';
+
+	hash_t small[SMALL_SET];
+	uint8_t smallCount;
+	uint8_t *registers;
+
+	void Initialize() {
+		smallCount = 0;
+		registers = nullptr;
+	}
+	void Destroy() {
+		delete[] registers;
+		registers = nullptr;
+	}
+	void AddRegister(hash_t hash) {
+		// the leading P bits select the register, it keeps the longest run of leading zeros seen in the rest
+		const auto idx = hash >> (64 - P);
+		const auto rest = hash << P;
+		const auto rank = rest == 0 ? uint8_t(64 - P + 1) : uint8_t(CountZeros<uint64_t>::Leading(rest) + 1);
+		if (registers[idx] < rank) {
+			registers[idx] = rank;
+		}
+	}
+	void Dense() {
+		registers = new uint8_t[REGISTERS];
+		memset(registers, 0, REGISTERS);
+		for (idx_t i = 0; i < smallCount; i++) {
+			AddRegister(small[i]);
+		}
+		smallCount = 0;
+	}
+	void Add(hash_t hash) {
+		if (registers) {
+			AddRegister(hash);
+			return;
+		}
+		for (idx_t i = 0; i < smallCount; i++) {
+			if (small[i] == hash) {
+				return;
+			}
+		}
+		if (smallCount < SMALL_SET) {
+			small[smallCount++] = hash;
+			return;
+		}
+		Dense();
+		AddRegister(hash);
+	}
+	void Merge(const UniqState &other) {
+		if (!other.registers) {
+			for (idx_t i = 0; i < other.smallCount; i++) {
+				Add(other.small[i]);
+			}
+			return;
+		}
+		if (!registers) {
+			Dense();
+		}
+		for (idx_t i = 0; i < REGISTERS; i++) {
+			registers[i] = MaxValue(registers[i], other.registers[i]);
+		}
+	}
+	uint64_t Estimate() const {
+		if (!registers) {
+			return smallCount;
+		}
+		double sum = 0;
+		idx_t zeros = 0;
+		for (idx_t i = 0; i < REGISTERS; i++) {
+			sum += std::ldexp(1.0, -int(registers[i]));
+			zeros += registers[i] == 0;
+		}
+		const double m = double(REGISTERS);
+		auto estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+		if (estimate <= 2.5 * m && zeros > 0) {
+			// linear counting is more accurate while many registers are still empty
+			estimate = m * std::log(m / double(zeros));
+		}
+		return uint64_t(std::llround(estimate));
+	}
+	string Serialize() const {
+		string out;
+		WriteRaw<uint8_t>(out, TAG);
+		WriteRaw<uint8_t>(out, P);
+		if (!registers) {
+			WriteRaw<uint8_t>(out, smallCount);
+			for (idx_t i = 0; i < smallCount; i++) {
+				WriteRaw<hash_t>(out, small[i]);
+			}
+			return out;
+		}
+		WriteRaw<uint8_t>(out, UINT8_MAX);
+		out.append(reinterpret_cast<const char *>(registers), REGISTERS);
+		return out;
+	}
+	void MergeSerialized(const string_t &blob, const char *function) {
+		StateReader reader(blob, function);
+		reader.Expect(TAG);
+		if (reader.Read<uint8_t>() != P) {
+			throw InvalidInputException("%s: state of a different precision", function);
+		}
+		const auto small_count = reader.Read<uint8_t>();
+		if (small_count != UINT8_MAX) {
+			for (idx_t i = 0; i < small_count; i++) {
+				Add(reader.Read<hash_t>());
+			}
+			return;
+		}
+		if (!registers) {
+			Dense();
+		}
+		for (idx_t i = 0; i < REGISTERS; i++) {
+			registers[i] = MaxValue(registers[i], reader.Read<uint8_t>());
+		}
+	}
+};
+
+struct UniqOperation {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state.Initialize();
+	}
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+		target.Merge(source);
+	}
+	template <class T, class STATE>
+	static void Finalize(STATE &state, T &target, AggregateFinalizeData &) {
+		target = state.Estimate();
+	}
+	template <class STATE>
+	static void Destroy(STATE &state, AggregateInputData &) {
+		state.Destroy();
+	}
+	template <class STATE>
+	static void Add(STATE &state, const hash_t &hash, AggregateInputData &) {
+		state.Add(hash);
+	}
+	static bool IgnoreNull() {
+		return true;
+	}
+};
+
+//! -State: the serialized sketch instead of its estimate
+struct SerializeStateOperation : UniqOperation {
+	template <class T, class STATE>
+	static void Finalize(STATE &state, T &target, AggregateFinalizeData &finalize_data) {
+		target = StringVector::AddStringOrBlob(finalize_data.result, state.Serialize());
+	}
+};
+
+//! -Merge: folds serialized sketches into the state
+template <const char *NAME>
+struct MergeStateOperation : UniqOperation {
+	template <class STATE>
+	static void Add(STATE &state, const string_t &blob, AggregateInputData &) {
+		state.MergeSerialized(blob, NAME);
+	}
+};
+
+//! Hashes of the input rows, NULL where the input is NULL
+static void HashInput(Vector &input, Vector &hashes, idx_t count) {
+	VectorOperations::Hash(input, hashes, count);
+	UnifiedVectorFormat format;
+	input.ToUnifiedFormat(count, format);
+	if (format.validity.AllValid()) {
+		return;
+	}
+	hashes.Flatten(count);
+	auto &validity = FlatVector::Validity(hashes);
+	for (idx_t i = 0; i < count; i++) {
+		if (!format.validity.RowIsValid(format.sel->get_index(i))) {
+			validity.SetInvalid(i);
+		}
+	}
+}
+
+template <class STATE>
+static void UniqScatterUpdate(Vector inputs[], AggregateInputData &aggr, idx_t input_count, Vector &states,
+                              idx_t count) {
+	Vector hashes(LogicalType::HASH, count);
+	HashInput(inputs[0], hashes, count);
+	RowScatterUpdate<STATE, hash_t, UniqOperation>(&hashes, aggr, 1, states, count);
+}
+
+template <class STATE>
+static void UniqSimpleUpdate(Vector inputs[], AggregateInputData &aggr, idx_t input_count, data_ptr_t state,
+                             idx_t count) {
+	Vector hashes(LogicalType::HASH, count);
+	HashInput(inputs[0], hashes, count);
+	RowSimpleUpdate<STATE, hash_t, UniqOperation>(&hashes, aggr, 1, state, count);
+}
+
+template <class STATE, class RESULT, class FINALIZE>
+static AggregateFunction HashedSketchFunction(const string &name, const LogicalType &return_type) {
+	return AggregateFunction(name, {LogicalType::ANY}, return_type, AggregateFunction::StateSize<STATE>,
+	                         AggregateFunction::StateInitialize<STATE, UniqOperation>, UniqScatterUpdate<STATE>,
+	                         AggregateFunction::StateCombine<STATE, UniqOperation>,
+	                         AggregateFunction::StateFinalize<STATE, RESULT, FINALIZE>, UniqSimpleUpdate<STATE>,
+	                         BindAggregate, AggregateFunction::StateDestroy<STATE, UniqOperation>);
+}
+
+template <class STATE, class RESULT, class FINALIZE, const char *NAME>
+static AggregateFunction MergeSketchFunction(const LogicalType &return_type) {
+	using OP = MergeStateOperation<NAME>;
+	return AggregateFunction(NAME, {LogicalType::BLOB}, return_type, AggregateFunction::StateSize<STATE>,
+	                         AggregateFunction::StateInitialize<STATE, UniqOperation>,
+	                         RowScatterUpdate<STATE, string_t, OP>, AggregateFunction::StateCombine<STATE, UniqOperation>,
+	                         AggregateFunction::StateFinalize<STATE, RESULT, FINALIZE>,
+	                         RowSimpleUpdate<STATE, string_t, OP>, BindAggregate,
+	                         AggregateFunction::StateDestroy<STATE, UniqOperation>);
+}
+
+//===--------------------------------------------------------------------===//
+// quantileTDigest
+//===--------------------------------------------------------------------===//
+
+//! Merging t-digest with the k1 scale function. Neighbouring centroids of a compressed digest span more than one
+//! unit of the scale, which bounds them by COMPRESSION + 1, so the digest fits fixed arrays. Points are buffered
+//! and merged in batches.
+struct TDigest {
+	static constexpr idx_t COMPRESSION = 100;
+	static constexpr idx_t MAX_CENTROIDS = COMPRESSION + 1;
+	static constexpr idx_t BUFFER = 4 * COMPRESSION;
+	static constexpr uint8_t TAG = 'T';
+
+	struct Centroid {
+		double mean;
+		double weight;
+	};
+
+	Centroid centroids[MAX_CENTROIDS];
+	idx_t count = 0;
+	Centroid buffer[BUFFER];
+	idx_t buffered = 0;
+	double total = 0;
+	double min = NumericLimits<double>::Maximum();
+	double max = NumericLimits<double>::Minimum();
+
+	static double Scale(double q) {
+		static const double PI = std::acos(-1.0);
+		return double(COMPRESSION) / (2 * PI) * std::asin(2 * MinValue(MaxValue(q, 0.0), 1.0) - 1);
+	}
+	void Add(double mean, double weight) {
+		if (buffered == BUFFER) {
+			Compress();
+		}
+		buffer[buffered++] = {mean, weight};
+		total += weight;
+		min = MinValue(min, mean);
+		max = MaxValue(max, mean);
+	}
+	void Compress() {
+		if (buffered == 0) {
+			return;
+		}
+		Centroid all[MAX_CENTROIDS + BUFFER];
+		memcpy(all, centroids, count * sizeof(Centroid));
+		memcpy(all + count, buffer, buffered * sizeof(Centroid));
+		const auto n = count + buffered;
+		std::sort(all, all + n, [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+		count = 0;
+		buffered = 0;
+		auto current = all[0];
+		double before = 0;
+		for (idx_t i = 1; i < n; i++) {
+			const auto merged = current.weight + all[i].weight;
+			const bool fits = Scale((before + merged) / total) - Scale(before / total) <= 1;
+			if (fits || count == MAX_CENTROIDS - 1) {
+				current.mean += (all[i].mean - current.mean) * all[i].weight / merged;
+				current.weight = merged;
+				continue;
+			}
+			centroids[count++] = current;
+			before += current.weight;
+			current = all[i];
+		}
+		centroids[count++] = current;
+	}
+	//! Interpolates between the centers of the neighbouring centroids, the ends between the extremes
+	double Quantile(double level) {
+		Compress();
+		if (count == 1) {
+			return centroids[0].mean;
+		}
+		const double target = level * total;
+		const auto &first = centroids[0];
+		if (target < first.weight / 2) {
+			return min + (first.mean - min) * target / (first.weight / 2);
+		}
+		double before = 0;
+		for (idx_t i = 0; i + 1 < count; i++) {
+			const auto &l = centroids[i];
+			const auto &r = centroids[i + 1];
+			const double l_center = before + l.weight / 2;
+			const double r_center = before + l.weight + r.weight / 2;
+			if (target <= r_center) {
+				return l.mean + (r.mean - l.mean) * (target - l_center) / (r_center - l_center);
+			}
+			before += l.weight;
+		}
+		const auto &last = centroids[count - 1];
+		const double last_center = total - last.weight / 2;
+		return MinValue(max, last.mean + (max - last.mean) * (target - last_center) / (last.weight / 2));
+	}
+	void Merge(const TDigest &other) {
+		for (idx_t i = 0; i < other.count; i++) {
+			Add(other.centroids[i].mean, other.centroids[i].weight);
+		}
+		for (idx_t i = 0; i < other.buffered; i++) {
+			Add(other.buffer[i].mean, other.buffer[i].weight);
+		}
+		min = MinValue(min, other.min);
+		max = MaxValue(max, other.max);
+	}
+};
+
+//! The digest is allocated with the first value, empty groups only hold the pointer
+struct TDigestState {
+	TDigest *digest;
+
+	void Initialize() {
+		digest = nullptr;
+	}
+	void Destroy() {
+		delete digest;
+		digest = nullptr;
+	}
+	TDigest &GetDigest() {
+		if (!digest) {
+			digest = new TDigest();
+		}
+		return *digest;
+	}
+	void Merge(const TDigestState &other) {
+		if (other.digest) {
+			GetDigest().Merge(*other.digest);
+		}
+	}
+	string Serialize() const {
+		string out;
+		WriteRaw<uint8_t>(out, TDigest::TAG);
+		if (!digest) {
+			WriteRaw<uint32_t>(out, 0);
+			return out;
+		}
+		digest->Compress();
+		WriteRaw<uint32_t>(out, UnsafeNumericCast<uint32_t>(digest->count));
+		WriteRaw<double>(out, digest->min);
+		WriteRaw<double>(out, digest->max);
+		for (idx_t i = 0; i < digest->count; i++) {
+			WriteRaw<double>(out, digest->centroids[i].mean);
+			WriteRaw<double>(out, digest->centroids[i].weight);
+		}
+		return out;
+	}
+	void MergeSerialized(const string_t &blob, const char *function) {
+		StateReader reader(blob, function);
+		reader.Expect(TDigest::TAG);
+		const auto centroid_count = reader.Read<uint32_t>();
+		if (centroid_count == 0) {
+			return;
+		}
+		auto &target = GetDigest();
+		const auto min = reader.Read<double>();
+		const auto max = reader.Read<double>();
+		for (idx_t i = 0; i < centroid_count; i++) {
+			const auto mean = reader.Read<double>();
+			target.Add(mean, reader.Read<double>());
+		}
+		target.min = MinValue(target.min, min);
+		target.max = MaxValue(target.max, max);
+	}
+};
+
+struct TDigestOperation : UniqOperation {
+	template <class STATE>
+	static void Add(STATE &state, const double &value, AggregateInputData &) {
+		if (!Value::IsNan(value)) {
+			state.GetDigest().Add(value, 1);
+		}
+	}
+	template <class T, class STATE>
+	static void Finalize(STATE &state, T &target, AggregateFinalizeData &finalize_data) {
+		if (!state.digest) {
+			finalize_data.ReturnNull();
+			return;
+		}
+		target = state.digest->Quantile(finalize_data.input.bind_data->Cast<ChAggregateBindData>().level);
+	}
+};
+
+static unique_ptr<FunctionData> BindQuantile(ClientContext &context, AggregateFunction &function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+	auto result = make_uniq<ChAggregateBindData>();
+	if (arguments.size() > 1) {
+		result->level = BindConstantParameter(context, function, arguments, 1).GetValue<double>();
+		if (result->level < 0 || result->level > 1) {
+			throw BinderException("%s: level must be between 0 and 1", function.name);
+		}
+	}
+	return std::move(result);
+}
+
+static AggregateFunction TDigestFunction(const string &name, const vector<LogicalType> &arguments,
+                                         const LogicalType &return_type, aggregate_update_t update,
+                                         aggregate_finalize_t finalize, aggregate_simple_update_t simple_update) {
+	return AggregateFunction(name, arguments, return_type, AggregateFunction::StateSize<TDigestState>,
+	                         AggregateFunction::StateInitialize<TDigestState, UniqOperation>, update,
+	                         AggregateFunction::StateCombine<TDigestState, UniqOperation>, finalize, simple_update,
+	                         BindQuantile, AggregateFunction::StateDestroy<TDigestState, UniqOperation>);
+}
+
+//===--------------------------------------------------------------------===//
+// topK, groupArray
+//===--------------------------------------------------------------------===//
+
+//! Space-saving summary of the most frequent values with a fixed number of counters: a new value takes over the
+//! counter with the lowest count and inherits that count as its error
+template <class T>
+struct TopKSummary {
+	using STORED = typename StoredValue<T>::TYPE;
+	struct Counter {
+		STORED value;
+		uint64_t count;
+		uint64_t error;
+	};
+	struct StoredHash {
+		size_t operator()(const STORED &value) const {
+			return StoredValue<T>::HashOf(value);
+		}
+	};
+
+	explicit TopKSummary(idx_t capacity_p) : capacity(capacity_p) {
+	}
+
+	idx_t capacity;
+	vector<Counter> counters;
+	unordered_map<STORED, idx_t, StoredHash> index;
+
+	void Add(const STORED &value, uint64_t count, uint64_t error) {
+		const auto entry = index.find(value);
+		if (entry != index.end()) {
+			counters[entry->second].count += count;
+			counters[entry->second].error += error;
+			return;
+		}
+		if (counters.size() < capacity) {
+			index.emplace(value, counters.size());
+			counters.push_back(Counter {value, count, error});
+			return;
+		}
+		idx_t victim = 0;
+		for (idx_t i = 1; i < counters.size(); i++) {
+			if (counters[i].count < counters[victim].count) {
+				victim = i;
+			}
+		}
+		const auto floor = counters[victim].count;
+		index.erase(counters[victim].value);
+		counters[victim] = Counter {value, floor + count, floor + error};
+		index.emplace(value, victim);
+	}
+	//! Counters of the k most frequent values, most frequent first
+	vector<idx_t> Top(idx_t k) const {
+		vector<idx_t> order;
+		for (idx_t i = 0; i < counters.size(); i++) {
+			order.push_back(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](idx_t a, idx_t b) {
+			return counters[a].count > counters[b].count ||
+			       (counters[a].count == counters[b].count && counters[a].error < counters[b].error);
+		});
+		order.resize(MinValue(order.size(), k));
+		return order;
+	}
+};
+
+template <class T>
+struct TopKState {
+	TopKSummary<T> *summary;
+};
+
+//! ClickHouse reserves three counters per returned value
+static constexpr idx_t TOP_K_COUNTERS_PER_VALUE = 3;
+
+template <class T>
+struct TopKOperation {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state.summary = nullptr;
+	}
+	template <class STATE>
+	static void Destroy(STATE &state, AggregateInputData &) {
+		delete state.summary;
+		state.summary = nullptr;
+	}
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+		if (!source.summary) {
+			return;
+		}
+		if (!target.summary) {
+			target.summary = new TopKSummary<T>(source.summary->capacity);
+		}
+		for (auto &counter : source.summary->counters) {
+			target.summary->Add(counter.value, counter.count, counter.error);
+		}
+	}
+	template <class STATE>
+	static void Add(STATE &state, const T &value, AggregateInputData &aggr) {
+		if (!state.summary) {
+			const auto k = aggr.bind_data->Cast<ChAggregateBindData>().k;
+			state.summary = new TopKSummary<T>(k * TOP_K_COUNTERS_PER_VALUE);
+		}
+		state.summary->Add(StoredValue<T>::Store(value), 1, 0);
+	}
+	static bool IgnoreNull() {
+		return true;
+	}
+};
+
+template <class T>
+static void TopKFinalize(Vector &states, AggregateInputData &aggr, Vector &result, idx_t count, idx_t offset) {
+	const auto k = aggr.bind_data->Cast<ChAggregateBindData>().k;
+	UnifiedVectorFormat state_format;
+	states.ToUnifiedFormat(count, state_format);
+	const auto state_data = UnifiedVectorFormat::GetData<TopKState<T> *>(state_format);
+	auto list_data = FlatVector::GetData<list_entry_t>(result);
+	auto list_size = ListVector::GetListSize(result);
+	for (idx_t i = 0; i < count; i++) {
+		const auto &state = *state_data[state_format.sel->get_index(i)];
+		auto &entry = list_data[i + offset];
+		entry.offset = list_size;
+		entry.length = 0;
+		if (!state.summary) {
+			continue;
+		}
+		const auto top = state.summary->Top(k);
+		ListVector::Reserve(result, list_size + top.size());
+		auto &child = ListVector::GetEntry(result);
+		auto child_data = FlatVector::GetData<T>(child);
+		for (const auto idx : top) {
+			child_data[list_size++] = StoredValue<T>::Load(child, state.summary->counters[idx].value);
+		}
+		entry.length = top.size();
+	}
+	ListVector::SetListSize(result, list_size);
+}
+
+template <class T>
+struct TopKCallbacks {
+	static void Set(AggregateFunction &function) {
+		using STATE = TopKState<T>;
+		using OP = TopKOperation<T>;
+		function.state_size = AggregateFunction::StateSize<STATE>;
+		function.initialize = AggregateFunction::StateInitialize<STATE, OP>;
+		function.update = RowScatterUpdate<STATE, T, OP>;
+		function.simple_update = RowSimpleUpdate<STATE, T, OP>;
+		function.combine = AggregateFunction::StateCombine<STATE, OP>;
+		function.finalize = TopKFinalize<T>;
+		function.destructor = AggregateFunction::StateDestroy<STATE, OP>;
+	}
+};
+
+//! The largest k accepted, as in ClickHouse
+static constexpr int64_t TOP_K_MAX = 0xFFFFFF;
+
+static unique_ptr<FunctionData> BindTopK(ClientContext &context, AggregateFunction &function,
+                                         vector<unique_ptr<Expression>> &arguments) {
+	auto result = make_uniq<ChAggregateBindData>();
+	if (arguments.size() > 1) {
+		const auto k = BindConstantParameter(context, function, arguments, 1).GetValue<int64_t>();
+		if (k <= 0 || k > TOP_K_MAX) {
+			throw BinderException("%s: k must be between 1 and %lld", function.name, TOP_K_MAX);
+		}
+		result->k = idx_t(k);
+	}
+	const auto &type = arguments[0]->return_type;
+	SetTypedCallbacks<TopKCallbacks>(function, type);
+	function.arguments[0] = type;
+	function.return_type = LogicalType::LIST(type);
+	return std::move(result);
+}
+
+template <class T>
+struct GroupArrayState {
+	vector<typename StoredValue<T>::TYPE> *values;
+};
+
+template <class T>
+struct GroupArrayOperation : TopKOperation<T> {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state.values = nullptr;
+	}
+	template <class STATE>
+	static void Destroy(STATE &state, AggregateInputData &) {
+		delete state.values;
+		state.values = nullptr;
+	}
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+		if (!source.values) {
+			return;
+		}
+		if (!target.values) {
+			target.values = new vector<typename StoredValue<T>::TYPE>();
+		}
+		target.values->insert(target.values->end(), source.values->begin(), source.values->end());
+	}
+	template <class STATE>
+	static void Add(STATE &state, const T &value, AggregateInputData &) {
+		if (!state.values) {
+			state.values = new vector<typename StoredValue<T>::TYPE>();
+		}
+		state.values->push_back(StoredValue<T>::Store(value));
+	}
+};
+
+template <class T>
+static void GroupArrayFinalize(Vector &states, AggregateInputData &aggr, Vector &result, idx_t count, idx_t offset) {
+	UnifiedVectorFormat state_format;
+	states.ToUnifiedFormat(count, state_format);
+	const auto state_data = UnifiedVectorFormat::GetData<GroupArrayState<T> *>(state_format);
+	auto list_data = FlatVector::GetData<list_entry_t>(result);
+	auto list_size = ListVector::GetListSize(result);
+	for (idx_t i = 0; i < count; i++) {
+		const auto &state = *state_data[state_format.sel->get_index(i)];
+		auto &entry = list_data[i + offset];
+		entry.offset = list_size;
+		entry.length = state.values ? state.values->size() : 0;
+		if (entry.length == 0) {
+			continue;
+		}
+		ListVector::Reserve(result, list_size + entry.length);
+		auto &child = ListVector::GetEntry(result);
+		auto child_data = FlatVector::GetData<T>(child);
+		for (auto &value : *state.values) {
+			child_data[list_size++] = StoredValue<T>::Load(child, value);
+		}
+	}
+	ListVector::SetListSize(result, list_size);
+}
+
+template <class T>
+struct GroupArrayCallbacks {
+	static void Set(AggregateFunction &function) {
+		using STATE = GroupArrayState<T>;
+		using OP = GroupArrayOperation<T>;
+		function.state_size = AggregateFunction::StateSize<STATE>;
+		function.initialize = AggregateFunction::StateInitialize<STATE, OP>;
+		function.update = RowScatterUpdate<STATE, T, OP>;
+		function.simple_update = RowSimpleUpdate<STATE, T, OP>;
+		function.combine = AggregateFunction::StateCombine<STATE, OP>;
+		function.finalize = GroupArrayFinalize<T>;
+		function.destructor = AggregateFunction::StateDestroy<STATE, OP>;
+	}
+};
+
+static unique_ptr<FunctionData> BindGroupArray(ClientContext &context, AggregateFunction &function,
+                                               vector<unique_ptr<Expression>> &arguments) {
+	const auto &type = arguments[0]->return_type;
+	SetTypedCallbacks<GroupArrayCallbacks>(function, type);
+	function.arguments[0] = type;
+	function.return_type = LogicalType::LIST(type);
+	return make_uniq<ChAggregateBindData>();
+}
+
+//===--------------------------------------------------------------------===//
+// argMax, argMin
+//===--------------------------------------------------------------------===//
+
+//! The best value seen and the argument of its row. The argument is only copied when the value improves.
+template <class T>
+struct ArgEntry {
+	typename StoredValue<T>::TYPE value;
+	Value arg;
+};
+
+template <class T>
+struct ArgState {
+	ArgEntry<T> *best;
+};
+
+template <class T, class COMPARE>
+struct ArgOperation {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state.best = nullptr;
+	}
+	template <class STATE>
+	static void Destroy(STATE &state, AggregateInputData &) {
+		delete state.best;
+		state.best = nullptr;
+	}
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+		if (!source.best) {
+			return;
+		}
+		if (!target.best) {
+			target.best = new ArgEntry<T>(*source.best);
+		} else if (COMPARE::Operation(StoredValue<T>::View(source.best->value),
+		                              StoredValue<T>::View(target.best->value))) {
+			*target.best = *source.best;
+		}
+	}
+	//! Rows with a NULL value are skipped, NULL arguments are kept
+	static void Update(ArgState<T> &state, Vector &args, idx_t row, const T &value) {
+		if (!state.best) {
+			state.best = new ArgEntry<T> {StoredValue<T>::Store(value), args.GetValue(row)};
+		} else if (COMPARE::Operation(value, StoredValue<T>::View(state.best->value))) {
+			state.best->value = StoredValue<T>::Store(value);
+			state.best->arg = args.GetValue(row);
+		}
+	}
+	static bool IgnoreNull() {
+		return true;
+	}
+};
+
+template <class T, class COMPARE>
+static void ArgScatterUpdate(Vector inputs[], AggregateInputData &, idx_t input_count, Vector &states, idx_t count) {
+	UnifiedVectorFormat value_format;
+	UnifiedVectorFormat state_format;
+	inputs[1].ToUnifiedFormat(count, value_format);
+	states.ToUnifiedFormat(count, state_format);
+	const auto values = UnifiedVectorFormat::GetData<T>(value_format);
+	const auto state_data = UnifiedVectorFormat::GetData<ArgState<T> *>(state_format);
+	for (idx_t i = 0; i < count; i++) {
+		const auto idx = value_format.sel->get_index(i);
+		if (value_format.validity.RowIsValid(idx)) {
+			ArgOperation<T, COMPARE>::Update(*state_data[state_format.sel->get_index(i)], inputs[0], i, values[idx]);
+		}
+	}
+}
+
+template <class T, class COMPARE>
+static void ArgSimpleUpdate(Vector inputs[], AggregateInputData &, idx_t input_count, data_ptr_t state_p,
+                            idx_t count) {
+	auto &state = *reinterpret_cast<ArgState<T> *>(state_p);
+	UnifiedVectorFormat value_format;
+	inputs[1].ToUnifiedFormat(count, value_format);
+	const auto values = UnifiedVectorFormat::GetData<T>(value_format);
+	for (idx_t i = 0; i < count; i++) {
+		const auto idx = value_format.sel->get_index(i);
+		if (value_format.validity.RowIsValid(idx)) {
+			ArgOperation<T, COMPARE>::Update(state, inputs[0], i, values[idx]);
+		}
+	}
+}
+
+template <class T>
+static void ArgFinalize(Vector &states, AggregateInputData &aggr, Vector &result, idx_t count, idx_t offset) {
+	UnifiedVectorFormat state_format;
+	states.ToUnifiedFormat(count, state_format);
+	const auto state_data = UnifiedVectorFormat::GetData<ArgState<T> *>(state_format);
+	for (idx_t i = 0; i < count; i++) {
+		const auto &state = *state_data[state_format.sel->get_index(i)];
+		result.SetValue(i + offset, state.best ? state.best->arg : Value(result.GetType()));
+	}
+}
+
+template <class COMPARE>
+struct ArgCallbacks {
+	template <class T>
+	struct Typed {
+		static void Set(AggregateFunction &function) {
+			using STATE = ArgState<T>;
+			using OP = ArgOperation<T, COMPARE>;
+			function.state_size = AggregateFunction::StateSize<STATE>;
+			function.initialize = AggregateFunction::StateInitialize<STATE, OP>;
+			function.update = ArgScatterUpdate<T, COMPARE>;
+			function.simple_update = ArgSimpleUpdate<T, COMPARE>;
+			function.combine = AggregateFunction::StateCombine<STATE, OP>;
+			function.finalize = ArgFinalize<T>;
+			function.destructor = AggregateFunction::StateDestroy<STATE, OP>;
+		}
+	};
+};
+
+template <class COMPARE>
+static unique_ptr<FunctionData> BindArg(ClientContext &context, AggregateFunction &function,
+                                        vector<unique_ptr<Expression>> &arguments) {
+	const auto &value_type = arguments[1]->return_type;
+	SetTypedCallbacks<ArgCallbacks<COMPARE>::template Typed>(function, value_type);
+	function.arguments = {arguments[0]->return_type, value_type};
+	function.return_type = arguments[0]->return_type;
+	return make_uniq<ChAggregateBindData>();
+}
+
+//===--------------------------------------------------------------------===//
+// -If
+//===--------------------------------------------------------------------===//
+
+//! Rows whose condition is true, NULL conditions count as false
+static idx_t SelectTrue(Vector &condition, idx_t count, SelectionVector &sel) {
+	UnifiedVectorFormat format;
+	condition.ToUnifiedFormat(count, format);
+	const auto data = UnifiedVectorFormat::GetData<bool>(format);
+	idx_t selected = 0;
+	for (idx_t i = 0; i < count; i++) {
+		const auto idx = format.sel->get_index(i);
+		if (format.validity.RowIsValid(idx) && data[idx]) {
+			sel.set_index(selected++, i);
+		}
+	}
+	return selected;
+}
+
+//! Slices the aggregated columns to the rows passing the condition, the last input
+static vector<Vector> SliceInputs(Vector inputs[], idx_t input_count, const SelectionVector &sel, idx_t selected) {
+	vector<Vector> sliced;
+	for (idx_t i = 0; i + 1 < input_count; i++) {
+		sliced.emplace_back(inputs[i], sel, selected);
+	}
+	return sliced;
+}
+
+static void IfScatterUpdate(Vector inputs[], AggregateInputData &aggr, idx_t input_count, Vector &states,
+                            idx_t count) {
+	SelectionVector sel(count);
+	const auto selected = SelectTrue(inputs[input_count - 1], count, sel);
+	if (selected == 0) {
+		return;
+	}
+	auto sliced = SliceInputs(inputs, input_count, sel, selected);
+	Vector sliced_states(states, sel, selected);
+	aggr.bind_data->Cast<ChAggregateBindData>().wrappedUpdate(sliced.data(), aggr, input_count - 1, sliced_states,
+	                                                          selected);
+}
+
+static void IfSimpleUpdate(Vector inputs[], AggregateInputData &aggr, idx_t input_count, data_ptr_t state,
+                           idx_t count) {
+	SelectionVector sel(count);
+	const auto selected = SelectTrue(inputs[input_count - 1], count, sel);
+	if (selected == 0) {
+		return;
+	}
+	auto sliced = SliceInputs(inputs, input_count, sel, selected);
+	aggr.bind_data->Cast<ChAggregateBindData>().wrappedSimpleUpdate(sliced.data(), aggr, input_count - 1, state,
+	                                                                selected);
+}
+
+//! Binds the wrapped aggregate without the condition, then filters its input by the condition
+template <bind_aggregate_function_t BIND>
+static unique_ptr<FunctionData> BindIf(ClientContext &context, AggregateFunction &function,
+                                       vector<unique_ptr<Expression>> &arguments) {
+	auto condition = std::move(arguments.back());
+	arguments.pop_back();
+	function.arguments.pop_back();
+	auto result = BIND(context, function, arguments);
+	auto &bind_data = result->Cast<ChAggregateBindData>();
+	bind_data.wrappedUpdate = function.update;
+	bind_data.wrappedSimpleUpdate = function.simple_update;
+	function.update = IfScatterUpdate;
+	function.simple_update = IfSimpleUpdate;
+	arguments.push_back(std::move(condition));
+	function.arguments.push_back(LogicalType::BOOLEAN);
+	return result;
+}
+
+//! The aggregate over the rows where a trailing boolean condition holds, e.g. uniqIf(user_id, ok)
+template <bind_aggregate_function_t BIND>
+static AggregateFunctionSet IfVariant(const AggregateFunctionSet &set) {
+	AggregateFunctionSet result(set.name + "If");
+	for (auto function : set.functions) {
+		function.name = result.name;
+		function.arguments.push_back(LogicalType::BOOLEAN);
+		function.bind = BindIf<BIND>;
+		result.AddFunction(function);
+	}
+	return result;
+}
+
+template <bind_aggregate_function_t BIND>
+static void RegisterWithIf(DatabaseInstance &instance, const AggregateFunctionSet &set) {
+	ExtensionUtil::RegisterFunction(instance, set);
+	ExtensionUtil::RegisterFunction(instance, IfVariant<BIND>(set));
+}
+
+static AggregateFunctionSet SingleFunctionSet(AggregateFunction function) {
+	AggregateFunctionSet set(function.name);
+	set.AddFunction(std::move(function));
+	return set;
+}
+
+//! Typed aggregates get their callbacks in bind, the placeholders only describe the signature
+static AggregateFunction TypedFunction(const string &name, vector<LogicalType> arguments,
+                                       bind_aggregate_function_t bind) {
+	AggregateFunction function(name, std::move(arguments), LogicalType::ANY, nullptr, nullptr, nullptr, nullptr,
+	                           nullptr, nullptr, bind);
+	return function;
+}
+
+static constexpr const char UNIQ_MERGE[] = "uniqMerge";
+static constexpr const char UNIQ_COMBINED_MERGE[] = "uniqCombinedMerge";
+static constexpr const char TDIGEST_MERGE[] = "quantileTDigestMerge";
+
+//! uniq: HLL with 2^14 registers. uniqCombined uses ClickHouse's default precision of 17.
+using UniqHLL = UniqState<14>;
+using UniqCombinedHLL = UniqState<17>;
+
+void RegisterAggregateFunctions(DatabaseInstance &instance) {
+	RegisterWithIf<BindAggregate>(
+	    instance, SingleFunctionSet(HashedSketchFunction<UniqHLL, uint64_t, UniqOperation>("uniq", LogicalType::UBIGINT)));
+	RegisterWithIf<BindAggregate>(instance,
+	                              SingleFunctionSet(HashedSketchFunction<UniqCombinedHLL, uint64_t, UniqOperation>(
+	                                  "uniqCombined", LogicalType::UBIGINT)));
+	ExtensionUtil::RegisterFunction(
+	    instance, HashedSketchFunction<UniqHLL, string_t, SerializeStateOperation>("uniqState", LogicalType::BLOB));
+	ExtensionUtil::RegisterFunction(instance,
+	                                HashedSketchFunction<UniqCombinedHLL, string_t, SerializeStateOperation>(
+	                                    "uniqCombinedState", LogicalType::BLOB));
+	ExtensionUtil::RegisterFunction(
+	    instance, MergeSketchFunction<UniqHLL, uint64_t, UniqOperation, UNIQ_MERGE>(LogicalType::UBIGINT));
+	ExtensionUtil::RegisterFunction(instance, MergeSketchFunction<UniqCombinedHLL, uint64_t, UniqOperation,
+	                                                              UNIQ_COMBINED_MERGE>(LogicalType::UBIGINT));
+
+	AggregateFunctionSet quantile("quantileTDigest");
+	AggregateFunctionSet quantile_merge(TDIGEST_MERGE);
+	for (idx_t with_level = 0; with_level < 2; with_level++) {
+		vector<LogicalType> arguments {LogicalType::DOUBLE};
+		vector<LogicalType> merge_arguments {LogicalType::BLOB};
+		if (with_level) {
+			arguments.push_back(LogicalType::DOUBLE);
+			merge_arguments.push_back(LogicalType::DOUBLE);
+		}
+		quantile.AddFunction(TDigestFunction(quantile.name, arguments, LogicalType::DOUBLE,
+		                                     RowScatterUpdate<TDigestState, double, TDigestOperation>,
+		                                     AggregateFunction::StateFinalize<TDigestState, double, TDigestOperation>,
+		                                     RowSimpleUpdate<TDigestState, double, TDigestOperation>));
+		quantile_merge.AddFunction(
+		    TDigestFunction(quantile_merge.name, merge_arguments, LogicalType::DOUBLE,
+		                    RowScatterUpdate<TDigestState, string_t, MergeStateOperation<TDIGEST_MERGE>>,
+		                    AggregateFunction::StateFinalize<TDigestState, double, TDigestOperation>,
+		                    RowSimpleUpdate<TDigestState, string_t, MergeStateOperation<TDIGEST_MERGE>>));
+	}
+	RegisterWithIf<BindQuantile>(instance, quantile);
+	ExtensionUtil::RegisterFunction(instance, quantile_merge);
+	ExtensionUtil::RegisterFunction(
+	    instance, TDigestFunction("quantileTDigestState", {LogicalType::DOUBLE}, LogicalType::BLOB,
+	                              RowScatterUpdate<TDigestState, double, TDigestOperation>,
+	                              AggregateFunction::StateFinalize<TDigestState, string_t, SerializeStateOperation>,
+	                              RowSimpleUpdate<TDigestState, double, TDigestOperation>));
+
+	AggregateFunctionSet top_k("topK");
+	top_k.AddFunction(TypedFunction(top_k.name, {LogicalType::ANY}, BindTopK));
+	top_k.AddFunction(TypedFunction(top_k.name, {LogicalType::ANY, LogicalType::BIGINT}, BindTopK));
+	RegisterWithIf<BindTopK>(instance, top_k);
+	RegisterWithIf<BindGroupArray>(instance,
+	                               SingleFunctionSet(TypedFunction("groupArray", {LogicalType::ANY}, BindGroupArray)));
+	// argMax and argMin resolve to core's arg_max and arg_min, function names being case-insensitive. Only the -If
+	// variants are registered, the plain sets would collide with core's overloads.
+	ExtensionUtil::RegisterFunction(
+	    instance, IfVariant<BindArg<GreaterThan>>(SingleFunctionSet(
+	                  TypedFunction("argMax", {LogicalType::ANY, LogicalType::ANY}, BindArg<GreaterThan>))));
+	ExtensionUtil::RegisterFunction(
+	    instance, IfVariant<BindArg<LessThan>>(SingleFunctionSet(
+	                  TypedFunction("argMin", {LogicalType::ANY, LogicalType::ANY}, BindArg<LessThan>))));
+}
+
+} // namespace duckdb
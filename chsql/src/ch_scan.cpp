@@ -0,0 +1,914 @@
+#include "ch_scan.hpp"
+#include "table_filter_select.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/date.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/common/types/decimal.hpp"
+#include "utf8proc_wrapper.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+//! A ClickHouse column type from the RowBinaryWithNamesAndTypes header, e.g. Nullable(DateTime64(3, 'UTC'))
+struct CHColumnType {
+	enum class Kind : uint8_t {
+		FIXED,
+		STRING,
+		FIXED_STRING,
+		DATE,
+		DATE32,
+		DATETIME,
+		DATETIME64,
+		UUID,
+		ENUM8,
+		ENUM16,
+		ARRAY
+	};
+	Kind kind = Kind::FIXED;
+	LogicalType type;
+	bool nullable = false;
+	//! Byte width of FIXED and FIXED_STRING values
+	idx_t width = 0;
+	//! DateTime64 ticks per microsecond (negative: microseconds per tick)
+	int64_t scale = 1;
+	unordered_map<int64_t, string> enum_names;
+	vector<CHColumnType> children;
+};
+
+//! Splits "a, b(c, d), 'e'" at top-level commas
+static vector<string> SplitTypeArguments(const string &arguments) {
+	vector<string> result;
+	idx_t depth = 0;
+	bool quoted = false;
+	string current;
+	for (idx_t i = 0; i < arguments.size(); i++) {
+		const auto c = arguments[i];
+		if (c == '\'' && (i == 0 || arguments[i - 1] != '\\')) {
+			quoted = !quoted;
+		} else if (!quoted && c == '(') {
+			depth++;
+		} else if (!quoted && c == ')') {
+			depth--;
+		} else if (!quoted && depth == 0 && c == ',') {
+			result.push_back(StringUtil::Strip(current));
+			current.clear();
+			continue;
+		}
+		current += c;
+	}
+	if (!StringUtil::Strip(current).empty()) {
+		result.push_back(StringUtil::Strip(current));
+	}
+	return result;
+}
+
+static string UnquoteTypeArgument(const string &argument) {
+	if (argument.size() >= 2 && argument.front() == '\'' && argument.back() == '\'') {
+		return argument.substr(1, argument.size() - 2);
+	}
+	return argument;
+}
+
+static CHColumnType ParseCHType(const string &type_string) {
+	const auto type_name = StringUtil::Strip(type_string);
+	string name = type_name;
+	vector<string> arguments;
+	const auto paren = type_name.find('(');
+	if (paren != string::npos && type_name.back() == ')') {
+		name = type_name.substr(0, paren);
+		arguments = SplitTypeArguments(type_name.substr(paren + 1, type_name.size() - paren - 2));
+	}
+
+	CHColumnType result;
+	if (name == "Nullable" && arguments.size() == 1) {
+		result = ParseCHType(arguments[0]);
+		result.nullable = true;
+		return result;
+	}
+	if (name == "LowCardinality" && arguments.size() == 1) {
+		// RowBinary writes LowCardinality columns as their plain values
+		return ParseCHType(arguments[0]);
+	}
+	if (name == "Array" && arguments.size() == 1) {
+		result.kind = CHColumnType::Kind::ARRAY;
+		result.children.push_back(ParseCHType(arguments[0]));
+		result.type = LogicalType::LIST(result.children[0].type);
+		return result;
+	}
+	static const struct {
+		const char *name;
+		LogicalTypeId type;
+		idx_t width;
+	} FIXED_TYPES[] = {{"Int8", LogicalTypeId::TINYINT, 1},      {"Int16", LogicalTypeId::SMALLINT, 2},
+	                   {"Int32", LogicalTypeId::INTEGER, 4},     {"Int64", LogicalTypeId::BIGINT, 8},
+	                   {"Int128", LogicalTypeId::HUGEINT, 16},   {"UInt8", LogicalTypeId::UTINYINT, 1},
+	                   {"UInt16", LogicalTypeId::USMALLINT, 2},  {"UInt32", LogicalTypeId::UINTEGER, 4},
+	                   {"UInt64", LogicalTypeId::UBIGINT, 8},    {"UInt128", LogicalTypeId::UHUGEINT, 16},
+	                   {"Float32", LogicalTypeId::FLOAT, 4},     {"Float64", LogicalTypeId::DOUBLE, 8},
+	                   {"Bool", LogicalTypeId::BOOLEAN, 1},      {"IPv4", LogicalTypeId::UINTEGER, 4}};
+	for (auto &fixed : FIXED_TYPES) {
+		if (name == fixed.name) {
+			result.type = LogicalType(fixed.type);
+			result.width = fixed.width;
+			return result;
+		}
+	}
+	if (name == "String") {
+		result.kind = CHColumnType::Kind::STRING;
+		result.type = LogicalType::VARCHAR;
+	} else if (name == "FixedString" && arguments.size() == 1) {
+		result.kind = CHColumnType::Kind::FIXED_STRING;
+		result.type = LogicalType::BLOB;
+		result.width = std::stoull(arguments[0]);
+	} else if (name == "IPv6") {
+		// same representation as IPv6StringToNum
+		result.kind = CHColumnType::Kind::FIXED_STRING;
+		result.type = LogicalType::BLOB;
+		result.width = 16;
+	} else if (name == "Date") {
+		result.kind = CHColumnType::Kind::DATE;
+		result.type = LogicalType::DATE;
+	} else if (name == "Date32") {
+		result.kind = CHColumnType::Kind::DATE32;
+		result.type = LogicalType::DATE;
+	} else if (name == "DateTime") {
+		result.kind = CHColumnType::Kind::DATETIME;
+		result.type = arguments.empty() ? LogicalType::TIMESTAMP : LogicalType::TIMESTAMP_TZ;
+	} else if (name == "DateTime64" && !arguments.empty()) {
+		result.kind = CHColumnType::Kind::DATETIME64;
+		result.type = arguments.size() == 1 ? LogicalType::TIMESTAMP : LogicalType::TIMESTAMP_TZ;
+		const auto precision = std::stoll(arguments[0]);
+		if (precision < 0 || precision > 9) {
+			throw InvalidInputException("ch_scan: unsupported DateTime64 precision %lld", precision);
+		}
+		int64_t factor = 1;
+		for (auto p = MinValue<int64_t>(precision, 6); p < MaxValue<int64_t>(precision, 6); p++) {
+			factor *= 10;
+		}
+		result.scale = precision <= 6 ? factor : -factor;
+	} else if (name == "UUID") {
+		result.kind = CHColumnType::Kind::UUID;
+		result.type = LogicalType::UUID;
+	} else if ((name == "Enum8" || name == "Enum16") && !arguments.empty()) {
+		result.kind = name == "Enum8" ? CHColumnType::Kind::ENUM8 : CHColumnType::Kind::ENUM16;
+		result.type = LogicalType::VARCHAR;
+		for (auto &argument : arguments) {
+			const auto equals = argument.rfind('=');
+			if (equals == string::npos) {
+				throw InvalidInputException("ch_scan: cannot parse enum type %s", type_name);
+			}
+			result.enum_names[std::stoll(argument.substr(equals + 1))] =
+			    UnquoteTypeArgument(StringUtil::Strip(argument.substr(0, equals)));
+		}
+	} else if (name == "Decimal" && arguments.size() == 2) {
+		const auto width = std::stoull(arguments[0]);
+		const auto scale = std::stoull(arguments[1]);
+		if (width > Decimal::MAX_WIDTH_DECIMAL) {
+			throw NotImplementedException("ch_scan: Decimal(%llu, %llu) is wider than DuckDB supports", width, scale);
+		}
+		// ClickHouse stores Decimal(P <= 9) as Int32 where DuckDB would pick an int16 below 5 digits
+		result.type = LogicalType::DECIMAL(uint8_t(MaxValue<idx_t>(width, 5)), uint8_t(scale));
+		result.width = width <= 9 ? 4 : (width <= 18 ? 8 : 16);
+	} else {
+		throw NotImplementedException("ch_scan: unsupported ClickHouse type %s", type_name);
+	}
+	return result;
+}
+
+//! Buffered forward-only reader over a FileHandle, which is an HTTP response when httpfs serves the URL
+class RowBinaryStream {
+public:
+	static constexpr idx_t BUFFER_SIZE = 1 << 20;
+
+	explicit RowBinaryStream(unique_ptr<FileHandle> handle_p)
+	    : handle(std::move(handle_p)), buffer(make_unsafe_uniq_array<data_t>(BUFFER_SIZE)) {
+	}
+
+	bool AtEnd() {
+		return pos == end && !Refill();
+	}
+
+	void Read(data_ptr_t target, idx_t size) {
+		while (size > 0) {
+			if (pos == end && !Refill()) {
+				throw IOException("ch_scan: unexpected end of RowBinary stream");
+			}
+			const auto available = MinValue<idx_t>(size, end - pos);
+			memcpy(target, buffer.get() + pos, available);
+			pos += available;
+			target += available;
+			size -= available;
+		}
+	}
+
+	template <class T>
+	T Read() {
+		T value;
+		if (end - pos >= sizeof(T)) {
+			memcpy(&value, buffer.get() + pos, sizeof(T));
+			pos += sizeof(T);
+		} else {
+			Read(data_ptr_cast(&value), sizeof(T));
+		}
+		return value;
+	}
+
+	uint64_t ReadVarInt() {
+		uint64_t result = 0;
+		for (idx_t shift = 0; shift < 64; shift += 7) {
+			const auto byte = Read<uint8_t>();
+			result |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) {
+				return result;
+			}
+		}
+		throw IOException("ch_scan: malformed varint in RowBinary stream");
+	}
+
+	//! Reads a length-prefixed string, straight from the buffer when it is contiguous
+	string_t ReadString(Vector &target) {
+		const auto size = ReadVarInt();
+		string_t result;
+		if (end - pos >= size) {
+			result = StringVector::AddStringOrBlob(target, const_char_ptr_cast(buffer.get() + pos), size);
+			pos += size;
+		} else {
+			result = StringVector::EmptyString(target, size);
+			Read(data_ptr_cast(result.GetDataWriteable()), size);
+			result.Finalize();
+		}
+		if (!Utf8Proc::IsValid(result.GetData(), result.GetSize())) {
+			throw InvalidInputException("ch_scan: String value is not valid UTF-8, cast it to a FixedString or "
+			                            "hex() it on the server");
+		}
+		return result;
+	}
+
+	string ReadString() {
+		string result(ReadVarInt(), '\0');
+		Read(data_ptr_cast(&result[0]), result.size());
+		return result;
+	}
+
+	void Skip(idx_t size) {
+		while (size > 0) {
+			if (pos == end && !Refill()) {
+				throw IOException("ch_scan: unexpected end of RowBinary stream");
+			}
+			const auto available = MinValue<idx_t>(size, end - pos);
+			pos += available;
+			size -= available;
+		}
+	}
+
+private:
+	bool Refill() {
+		pos = 0;
+		end = 0;
+		auto read = handle->Read(buffer.get(), BUFFER_SIZE);
+		end = read > 0 ? idx_t(read) : 0;
+		return end > 0;
+	}
+
+	unique_ptr<FileHandle> handle;
+	unsafe_unique_array<data_t> buffer;
+	idx_t pos = 0;
+	idx_t end = 0;
+};
+
+static void ReadCHValue(RowBinaryStream &stream, const CHColumnType &type, Vector &vector, idx_t row);
+
+//! Consumes a value of a column that is not projected
+static void SkipCHValue(RowBinaryStream &stream, const CHColumnType &type) {
+	if (type.nullable && stream.Read<uint8_t>()) {
+		return;
+	}
+	switch (type.kind) {
+	case CHColumnType::Kind::FIXED:
+	case CHColumnType::Kind::FIXED_STRING:
+		stream.Skip(type.width);
+		break;
+	case CHColumnType::Kind::STRING:
+		stream.Skip(stream.ReadVarInt());
+		break;
+	case CHColumnType::Kind::DATE:
+	case CHColumnType::Kind::ENUM16:
+		stream.Skip(2);
+		break;
+	case CHColumnType::Kind::ENUM8:
+		stream.Skip(1);
+		break;
+	case CHColumnType::Kind::DATE32:
+	case CHColumnType::Kind::DATETIME:
+		stream.Skip(4);
+		break;
+	case CHColumnType::Kind::DATETIME64:
+		stream.Skip(8);
+		break;
+	case CHColumnType::Kind::UUID:
+		stream.Skip(16);
+		break;
+	case CHColumnType::Kind::ARRAY: {
+		const auto size = stream.ReadVarInt();
+		for (idx_t i = 0; i < size; i++) {
+			SkipCHValue(stream, type.children[0]);
+		}
+		break;
+	}
+	}
+}
+
+static timestamp_t DateTime64ToTimestamp(int64_t ticks, int64_t scale) {
+	return timestamp_t(scale >= 0 ? ticks * scale : ticks / -scale);
+}
+
+static void ReadCHValue(RowBinaryStream &stream, const CHColumnType &type, Vector &vector, idx_t row) {
+	if (type.nullable && stream.Read<uint8_t>()) {
+		FlatVector::SetNull(vector, row, true);
+		return;
+	}
+	switch (type.kind) {
+	case CHColumnType::Kind::FIXED:
+		// fixed-width ClickHouse values are little endian and laid out like DuckDB's, Int128 included
+		stream.Read(FlatVector::GetData(vector) + row * type.width, type.width);
+		break;
+	case CHColumnType::Kind::STRING:
+		FlatVector::GetData<string_t>(vector)[row] = stream.ReadString(vector);
+		break;
+	case CHColumnType::Kind::FIXED_STRING: {
+		auto value = StringVector::EmptyString(vector, type.width);
+		stream.Read(data_ptr_cast(value.GetDataWriteable()), type.width);
+		value.Finalize();
+		FlatVector::GetData<string_t>(vector)[row] = value;
+		break;
+	}
+	case CHColumnType::Kind::DATE:
+		FlatVector::GetData<date_t>(vector)[row] = date_t(int32_t(stream.Read<uint16_t>()));
+		break;
+	case CHColumnType::Kind::DATE32:
+		FlatVector::GetData<date_t>(vector)[row] = date_t(stream.Read<int32_t>());
+		break;
+	case CHColumnType::Kind::DATETIME:
+		FlatVector::GetData<timestamp_t>(vector)[row] =
+		    Timestamp::FromEpochSeconds(int64_t(stream.Read<uint32_t>()));
+		break;
+	case CHColumnType::Kind::DATETIME64:
+		FlatVector::GetData<timestamp_t>(vector)[row] = DateTime64ToTimestamp(stream.Read<int64_t>(), type.scale);
+		break;
+	case CHColumnType::Kind::UUID: {
+		// two little endian 64 bit halves, high half first; DuckDB flips the top bit to keep UUIDs sortable
+		const auto high = stream.Read<uint64_t>();
+		const auto low = stream.Read<uint64_t>();
+		hugeint_t value;
+		value.upper = int64_t(high ^ (uint64_t(1) << 63));
+		value.lower = low;
+		FlatVector::GetData<hugeint_t>(vector)[row] = value;
+		break;
+	}
+	case CHColumnType::Kind::ENUM8:
+	case CHColumnType::Kind::ENUM16: {
+		const auto code = type.kind == CHColumnType::Kind::ENUM8 ? int64_t(stream.Read<int8_t>())
+		                                                          : int64_t(stream.Read<int16_t>());
+		auto entry = type.enum_names.find(code);
+		if (entry == type.enum_names.end()) {
+			throw IOException("ch_scan: unknown enum value %lld", code);
+		}
+		FlatVector::GetData<string_t>(vector)[row] = StringVector::AddString(vector, entry->second);
+		break;
+	}
+	case CHColumnType::Kind::ARRAY: {
+		const auto size = stream.ReadVarInt();
+		const auto offset = ListVector::GetListSize(vector);
+		ListVector::Reserve(vector, offset + size);
+		auto &child = ListVector::GetEntry(vector);
+		for (idx_t i = 0; i < size; i++) {
+			ReadCHValue(stream, type.children[0], child, offset + i);
+		}
+		ListVector::SetListSize(vector, offset + size);
+		FlatVector::GetData<list_entry_t>(vector)[row] = list_entry_t(offset, size);
+		break;
+	}
+	}
+}
+
+struct CHScanBindData : TableFunctionData {
+	//! Opened by the scan, bind only reads the header of a probe
+	string path;
+	vector<CHColumnType> columns;
+	vector<string> type_names;
+};
+
+struct CHScanGlobalState : GlobalTableFunctionState {
+	unique_ptr<RowBinaryStream> stream;
+	vector<column_t> column_ids;
+	bool finished = false;
+};
+
+static unique_ptr<RowBinaryStream> OpenRowBinary(ClientContext &context, const string &path, vector<string> &names,
+												 vector<string> &types) {
+	auto &fs = FileSystem::GetFileSystem(context);
+	auto stream = make_uniq<RowBinaryStream>(fs.OpenFile(path, FileFlags::FILE_FLAGS_READ));
+	if (stream->AtEnd()) {
+		throw IOException("ch_scan: empty response from %s", path);
+	}
+	const auto column_count = stream->ReadVarInt();
+	for (idx_t i = 0; i < column_count; i++) {
+		names.push_back(stream->ReadString());
+	}
+	for (idx_t i = 0; i < column_count; i++) {
+		types.push_back(stream->ReadString());
+	}
+	return stream;
+}
+
+static string ClickHouseQueryURL(const string &server, const string &user, const string &query) {
+	return server + "/?default_format=RowBinaryWithNamesAndTypes&user=" + StringUtil::URLEncode(user) +
+	       "&query=" + StringUtil::URLEncode(query);
+}
+
+//! The query wrapped into LIMIT 0: its response is just the header, so binding (DESCRIBE, PREPARE) learns the
+//! result columns without running the query
+static string CHProbeQuery(const string &query) {
+	auto end = query.size();
+	while (end > 0 && (StringUtil::CharacterIsSpace(query[end - 1]) || query[end - 1] == ';')) {
+		end--;
+	}
+	// on a line of its own the parenthesis survives a trailing -- comment
+	return "SELECT * FROM (" + query.substr(0, end) + "\n) LIMIT 0";
+}
+
+//! Decodes up to STANDARD_VECTOR_SIZE rows; output_column maps every stream column to its output vector or
+//! INVALID_INDEX when the column is not projected
+static idx_t DecodeRows(RowBinaryStream &stream, const vector<CHColumnType> &columns,
+						const vector<idx_t> &output_column, DataChunk &output) {
+	idx_t count = 0;
+	while (count < STANDARD_VECTOR_SIZE && !stream.AtEnd()) {
+		for (idx_t col = 0; col < columns.size(); col++) {
+			if (output_column[col] == DConstants::INVALID_INDEX) {
+				SkipCHValue(stream, columns[col]);
+			} else {
+				ReadCHValue(stream, columns[col], output.data[output_column[col]], count);
+			}
+		}
+		count++;
+	}
+	return count;
+}
+
+//! Reads the result columns from the header of probe_path, the scan then streams path
+static unique_ptr<FunctionData> RowBinaryBind(ClientContext &context, const string &path, const string &probe_path,
+											  vector<LogicalType> &return_types, vector<string> &names) {
+	auto result = make_uniq<CHScanBindData>();
+	result->path = path;
+	auto &type_names = result->type_names;
+	OpenRowBinary(context, probe_path, names, type_names);
+	for (auto &type_name : type_names) {
+		result->columns.push_back(ParseCHType(type_name));
+		return_types.push_back(result->columns.back().type);
+	}
+	return std::move(result);
+}
+
+static unique_ptr<FunctionData> ReadCHRowBinaryBind(ClientContext &context, TableFunctionBindInput &input,
+													vector<LogicalType> &return_types, vector<string> &names) {
+	const auto path = input.inputs[0].GetValue<string>();
+	return RowBinaryBind(context, path, path, return_types, names);
+}
+
+//! ch_scan(query, server [, user := 'play']) asks the ClickHouse HTTP interface for RowBinaryWithNamesAndTypes.
+//! Bind sends the LIMIT 0 probe of the query, the query itself only runs when the scan starts.
+static unique_ptr<FunctionData> CHScanBind(ClientContext &context, TableFunctionBindInput &input,
+										   vector<LogicalType> &return_types, vector<string> &names) {
+	const auto query = input.inputs[0].GetValue<string>();
+	const auto server = input.inputs[1].GetValue<string>();
+	string user = "play";
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "user") {
+			user = kv.second.GetValue<string>();
+		}
+	}
+	return RowBinaryBind(context, ClickHouseQueryURL(server, user, query),
+						 ClickHouseQueryURL(server, user, CHProbeQuery(query)), return_types, names);
+}
+
+static unique_ptr<GlobalTableFunctionState> CHScanInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<CHScanBindData>();
+	auto result = make_uniq<CHScanGlobalState>();
+	result->column_ids = input.column_ids;
+	vector<string> names, types;
+	result->stream = OpenRowBinary(context, bind_data.path, names, types);
+	if (types != bind_data.type_names) {
+		throw IOException("ch_scan: result header of %s changed since bind", bind_data.path);
+	}
+	return std::move(result);
+}
+
+static void CHScanFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<CHScanBindData>();
+	auto &state = data.global_state->Cast<CHScanGlobalState>();
+	if (state.finished) {
+		return;
+	}
+	vector<idx_t> output_column(bind_data.columns.size(), DConstants::INVALID_INDEX);
+	for (idx_t i = 0; i < state.column_ids.size(); i++) {
+		if (!IsRowIdColumnId(state.column_ids[i])) {
+			output_column[state.column_ids[i]] = i;
+		}
+	}
+	const auto count = DecodeRows(*state.stream, bind_data.columns, output_column, output);
+	if (count == 0) {
+		state.finished = true;
+		state.stream.reset();
+	}
+	output.SetCardinality(count);
+}
+
+//! Backtick-quoted ClickHouse identifier
+static string QuoteCHIdentifier(const string &name) {
+	return "`" + StringUtil::Replace(StringUtil::Replace(name, "\\", "\\\\"), "`", "\\`") + "`";
+}
+
+static string CHStringLiteral(const string &value) {
+	return "'" + StringUtil::Replace(StringUtil::Replace(value, "\\", "\\\\"), "'", "\\'") + "'";
+}
+
+//! unhex('...') literal of a byte string, which CHStringLiteral would mangle through the \xNN escapes of ToString
+static string CHBytesLiteral(const string &bytes) {
+	static constexpr const char *HEX_DIGITS = "0123456789ABCDEF";
+	string hex;
+	for (auto c : bytes) {
+		hex += HEX_DIGITS[uint8_t(c) >> 4];
+		hex += HEX_DIGITS[uint8_t(c) & 0xf];
+	}
+	return "unhex('" + hex + "')";
+}
+
+static string CHLiteral(const Value &value) {
+	switch (value.type().id()) {
+	case LogicalTypeId::BOOLEAN:
+		return value.GetValue<bool>() ? "true" : "false";
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+	case LogicalTypeId::HUGEINT:
+	case LogicalTypeId::UTINYINT:
+	case LogicalTypeId::USMALLINT:
+	case LogicalTypeId::UINTEGER:
+	case LogicalTypeId::UBIGINT:
+	case LogicalTypeId::UHUGEINT:
+	case LogicalTypeId::FLOAT:
+	case LogicalTypeId::DOUBLE:
+	case LogicalTypeId::DECIMAL:
+		return value.ToString();
+	case LogicalTypeId::DATE:
+		return "toDate32(" + CHStringLiteral(value.ToString()) + ")";
+	case LogicalTypeId::TIMESTAMP:
+	case LogicalTypeId::TIMESTAMP_TZ:
+		// DateTime values decode as UTC, so the literal must not be read in the server's timezone
+		return "toDateTime64(" + CHStringLiteral(Timestamp::ToString(value.GetValueUnsafe<timestamp_t>())) +
+		       ", 6, 'UTC')";
+	case LogicalTypeId::BLOB:
+		return CHBytesLiteral(StringValue::Get(value));
+	case LogicalTypeId::UUID:
+		return "toUUID(" + CHStringLiteral(value.ToString()) + ")";
+	default:
+		return CHStringLiteral(value.ToString());
+	}
+}
+
+static const char *CHComparisonOperator(ExpressionType type) {
+	switch (type) {
+	case ExpressionType::COMPARE_EQUAL:
+		return " = ";
+	case ExpressionType::COMPARE_NOTEQUAL:
+		return " != ";
+	case ExpressionType::COMPARE_LESSTHAN:
+		return " < ";
+	case ExpressionType::COMPARE_GREATERTHAN:
+		return " > ";
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		return " <= ";
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		return " >= ";
+	default:
+		return nullptr;
+	}
+}
+
+//! Whether filters on a column mean the same to ClickHouse. Enums decode to VARCHAR but ClickHouse orders them by
+//! code, FixedString and IPv6 compare differently to the BLOBs they decode to, and arrays have no literal here.
+static bool CHFilterPushable(const CHColumnType &column) {
+	switch (column.kind) {
+	case CHColumnType::Kind::ENUM8:
+	case CHColumnType::Kind::ENUM16:
+	case CHColumnType::Kind::FIXED_STRING:
+	case CHColumnType::Kind::ARRAY:
+		return false;
+	default:
+		return true;
+	}
+}
+
+//! Renders a pushed-down filter as a ClickHouse condition. Returns false when it cannot be expressed, the scan then
+//! evaluates the filter itself.
+static bool CHFilterCondition(const string &column, const TableFilter &filter, string &condition) {
+	switch (filter.filter_type) {
+	case TableFilterType::CONSTANT_COMPARISON: {
+		auto &constant_filter = filter.Cast<ConstantFilter>();
+		auto op = CHComparisonOperator(constant_filter.comparison_type);
+		if (!op) {
+			return false;
+		}
+		condition = column + op + CHLiteral(constant_filter.constant);
+		return true;
+	}
+	case TableFilterType::IS_NULL:
+		condition = "isNull(" + column + ")";
+		return true;
+	case TableFilterType::IS_NOT_NULL:
+		condition = "isNotNull(" + column + ")";
+		return true;
+	case TableFilterType::CONJUNCTION_AND:
+	case TableFilterType::CONJUNCTION_OR: {
+		const bool is_and = filter.filter_type == TableFilterType::CONJUNCTION_AND;
+		auto &children = is_and ? filter.Cast<ConjunctionAndFilter>().child_filters
+		                        : filter.Cast<ConjunctionOrFilter>().child_filters;
+		vector<string> parts;
+		for (auto &child : children) {
+			string part;
+			if (!CHFilterCondition(column, *child, part)) {
+				return false;
+			}
+			parts.push_back("(" + part + ")");
+		}
+		condition = StringUtil::Join(parts, is_and ? " AND " : " OR ");
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+//! One sub-query of ch_scan_table, with the column layout of its response
+struct CHTableScanGlobalState : GlobalTableFunctionState {
+	mutex lock;
+	vector<string> urls;
+	idx_t next_url = 0;
+	//! Output vector of every column of the sub-query responses, INVALID_INDEX for the placeholder column
+	vector<idx_t> output_column;
+	//! Filters ClickHouse could not be given, evaluated locally on the decoded rows
+	vector<pair<idx_t, const TableFilter *>> local_filters;
+
+	idx_t MaxThreads() const override {
+		return urls.size();
+	}
+};
+
+struct CHTableScanLocalState : LocalTableFunctionState {
+	unique_ptr<RowBinaryStream> stream;
+	vector<CHColumnType> columns;
+};
+
+struct CHTableScanBindData : TableFunctionData {
+	string server;
+	string user;
+	string table;
+	string partition_key;
+	idx_t partitions = 0;
+	vector<string> names;
+	vector<CHColumnType> columns;
+};
+
+//! ch_scan_table(table, server [, partition_key, partitions, user]) reads the table header with a LIMIT 0 query
+static unique_ptr<FunctionData> CHScanTableBind(ClientContext &context, TableFunctionBindInput &input,
+												vector<LogicalType> &return_types, vector<string> &names) {
+	auto result = make_uniq<CHTableScanBindData>();
+	result->table = input.inputs[0].GetValue<string>();
+	result->server = input.inputs[1].GetValue<string>();
+	result->user = "play";
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "user") {
+			result->user = kv.second.GetValue<string>();
+		} else if (kv.first == "partition_key") {
+			result->partition_key = kv.second.GetValue<string>();
+		} else if (kv.first == "partitions") {
+			result->partitions = kv.second.GetValue<idx_t>();
+		}
+	}
+	vector<string> type_names;
+	OpenRowBinary(context, ClickHouseQueryURL(result->server, result->user, "SELECT * FROM " + result->table + " LIMIT 0"),
+				  names, type_names);
+	for (auto &type_name : type_names) {
+		result->columns.push_back(ParseCHType(type_name));
+		return_types.push_back(result->columns.back().type);
+	}
+	if (!result->partition_key.empty() &&
+		std::find(names.begin(), names.end(), result->partition_key) == names.end() &&
+		result->partition_key != "_partition_id") {
+		throw BinderException("ch_scan_table: partition key \"%s\" is not a column of %s", result->partition_key,
+							  result->table);
+	}
+	result->names = names;
+	return std::move(result);
+}
+
+//! Splits the scan on the partition key: integer-like keys into contiguous ranges between the key's min and max so
+//! ClickHouse can use its primary key, anything else (including _partition_id) by hash. The outer ranges are open
+//! ended, so rows inserted since the min/max query still land in a partition. Keys that toInt64 could wrap and
+//! nullable keys are hashed, their NULLs get a partition of their own.
+static vector<string> CHPartitionConditions(ClientContext &context, const CHTableScanBindData &bind_data,
+											const string &where, idx_t partitions) {
+	vector<string> conditions;
+	const auto key = bind_data.partition_key == "_partition_id" ? bind_data.partition_key
+	                                                            : QuoteCHIdentifier(bind_data.partition_key);
+	auto key_idx = std::find(bind_data.names.begin(), bind_data.names.end(), bind_data.partition_key) -
+	               bind_data.names.begin();
+	bool ranged = false;
+	bool nullable = false;
+	if (idx_t(key_idx) < bind_data.columns.size()) {
+		auto &key_column = bind_data.columns[key_idx];
+		const auto key_type = key_column.type.id();
+		nullable = key_column.nullable;
+		ranged = !nullable && key_column.kind != CHColumnType::Kind::ARRAY &&
+		         ((key_column.type.IsIntegral() && key_type != LogicalTypeId::UBIGINT &&
+		           key_type != LogicalTypeId::HUGEINT && key_type != LogicalTypeId::UHUGEINT) ||
+		          key_type == LogicalTypeId::DATE || key_type == LogicalTypeId::TIMESTAMP ||
+		          key_type == LogicalTypeId::TIMESTAMP_TZ);
+	}
+	if (ranged) {
+		vector<string> names, types;
+		auto stream = OpenRowBinary(context,
+									ClickHouseQueryURL(bind_data.server, bind_data.user,
+													   "SELECT toInt64(min(" + key + ")), toInt64(max(" + key +
+														   ")) FROM " + bind_data.table + where),
+									names, types);
+		if (types.size() != 2 || types[0] != "Int64" || types[1] != "Int64") {
+			throw IOException("ch_scan_table: unexpected response to the partition key range query");
+		}
+		const auto lo = stream->Read<int64_t>();
+		const auto hi = stream->Read<int64_t>();
+		const auto span = uint64_t(hi) - uint64_t(lo) + 1;
+		if (span != 0 && span < partitions) {
+			partitions = span;
+		}
+		const auto step = span == 0 ? uint64_t(-1) / partitions : span / partitions;
+		for (idx_t i = 0; i < partitions; i++) {
+			const auto begin = int64_t(uint64_t(lo) + i * step);
+			vector<string> bounds;
+			if (i > 0) {
+				bounds.push_back("toInt64(" + key + ") >= " + to_string(begin));
+			}
+			if (i + 1 < partitions) {
+				bounds.push_back("toInt64(" + key + ") < " + to_string(int64_t(uint64_t(begin) + step)));
+			}
+			conditions.push_back(bounds.empty() ? "true" : StringUtil::Join(bounds, " AND "));
+		}
+		return conditions;
+	}
+	for (idx_t i = 0; i < partitions; i++) {
+		auto condition = "cityHash64(" + key + ") % " + to_string(partitions) + " = " + to_string(i);
+		conditions.push_back(nullable ? "isNotNull(" + key + ") AND " + condition : condition);
+	}
+	if (nullable) {
+		conditions.push_back("isNull(" + key + ")");
+	}
+	return conditions;
+}
+
+static unique_ptr<GlobalTableFunctionState> CHScanTableInitGlobal(ClientContext &context,
+																   TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<CHTableScanBindData>();
+	auto result = make_uniq<CHTableScanGlobalState>();
+
+	// projected columns, in output order
+	vector<string> select_list;
+	for (idx_t i = 0; i < input.column_ids.size(); i++) {
+		if (!IsRowIdColumnId(input.column_ids[i])) {
+			select_list.push_back(QuoteCHIdentifier(bind_data.names[input.column_ids[i]]));
+			result->output_column.push_back(i);
+		}
+	}
+	if (select_list.empty()) {
+		// count(*): ClickHouse still needs something to select
+		select_list.push_back("1");
+		result->output_column.push_back(DConstants::INVALID_INDEX);
+	}
+
+	vector<string> conditions;
+	if (input.filters) {
+		for (auto &entry : input.filters->filters) {
+			const auto column_id = input.column_ids[entry.first];
+			string condition;
+			if (CHFilterPushable(bind_data.columns[column_id]) &&
+			    CHFilterCondition(QuoteCHIdentifier(bind_data.names[column_id]), *entry.second, condition)) {
+				conditions.push_back("(" + condition + ")");
+			} else {
+				result->local_filters.emplace_back(entry.first, entry.second.get());
+			}
+		}
+	}
+	const auto where = conditions.empty() ? string() : " WHERE " + StringUtil::Join(conditions, " AND ");
+	const auto query = "SELECT " + StringUtil::Join(select_list, ", ") + " FROM " + bind_data.table + where;
+
+	idx_t partitions = bind_data.partitions;
+	if (partitions == 0) {
+		partitions = idx_t(TaskScheduler::GetScheduler(context).NumberOfThreads());
+	}
+	if (bind_data.partition_key.empty() || partitions <= 1) {
+		result->urls.push_back(ClickHouseQueryURL(bind_data.server, bind_data.user, query));
+	} else {
+		for (auto &partition : CHPartitionConditions(context, bind_data, where, partitions)) {
+			const auto partition_query = query + (where.empty() ? " WHERE " : " AND ") + "(" + partition + ")";
+			result->urls.push_back(ClickHouseQueryURL(bind_data.server, bind_data.user, partition_query));
+		}
+	}
+	return std::move(result);
+}
+
+static unique_ptr<LocalTableFunctionState> CHScanTableInitLocal(ExecutionContext &context,
+																 TableFunctionInitInput &input,
+																 GlobalTableFunctionState *global_state) {
+	return make_uniq<CHTableScanLocalState>();
+}
+
+static void CHScanTableFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<CHTableScanGlobalState>();
+	auto &local = data.local_state->Cast<CHTableScanLocalState>();
+	while (true) {
+		if (!local.stream) {
+			string url;
+			{
+				lock_guard<mutex> guard(state.lock);
+				if (state.next_url >= state.urls.size()) {
+					return;
+				}
+				url = state.urls[state.next_url++];
+			}
+			vector<string> names, types;
+			local.stream = OpenRowBinary(context, url, names, types);
+			if (types.size() != state.output_column.size()) {
+				throw IOException("ch_scan_table: unexpected column count in sub-query response");
+			}
+			local.columns.clear();
+			for (auto &type_name : types) {
+				local.columns.push_back(ParseCHType(type_name));
+			}
+		}
+		auto count = DecodeRows(*local.stream, local.columns, state.output_column, output);
+		if (count == 0) {
+			local.stream.reset();
+			continue;
+		}
+		output.SetCardinality(count);
+		if (!state.local_filters.empty()) {
+			SelectionVector sel(STANDARD_VECTOR_SIZE);
+			idx_t selected = 0;
+			for (idx_t i = 0; i < count; i++) {
+				sel.set_index(selected++, i);
+			}
+			for (auto &filter : state.local_filters) {
+				selected = SelectTableFilter(output.data[filter.first], count, *filter.second, sel, selected);
+			}
+			if (selected == 0) {
+				output.Reset();
+				continue;
+			}
+			if (selected < count) {
+				output.Slice(sel, selected);
+			}
+		}
+		return;
+	}
+}
+
+void RegisterClickHouseScan(DatabaseInstance &instance) {
+	TableFunction ch_scan("ch_scan", {LogicalType::VARCHAR, LogicalType::VARCHAR}, CHScanFunction, CHScanBind,
+						  CHScanInitGlobal);
+	ch_scan.named_parameters["user"] = LogicalType::VARCHAR;
+	ch_scan.projection_pushdown = true;
+	ExtensionUtil::RegisterFunction(instance, ch_scan);
+
+	TableFunction read_rowbinary("read_ch_rowbinary", {LogicalType::VARCHAR}, CHScanFunction, ReadCHRowBinaryBind,
+								 CHScanInitGlobal);
+	read_rowbinary.projection_pushdown = true;
+	ExtensionUtil::RegisterFunction(instance, read_rowbinary);
+
+	TableFunction ch_scan_table("ch_scan_table", {LogicalType::VARCHAR, LogicalType::VARCHAR}, CHScanTableFunction,
+								CHScanTableBind, CHScanTableInitGlobal, CHScanTableInitLocal);
+	ch_scan_table.named_parameters["user"] = LogicalType::VARCHAR;
+	ch_scan_table.named_parameters["partition_key"] = LogicalType::VARCHAR;
+	ch_scan_table.named_parameters["partitions"] = LogicalType::UBIGINT;
+	ch_scan_table.projection_pushdown = true;
+	ch_scan_table.filter_pushdown = true;
+	ExtensionUtil::RegisterFunction(instance, ch_scan_table);
+}
+
+} // namespace duckdb
@@ -0,0 +1,108 @@
+#include "conversion_functions.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+namespace duckdb {
+
+//! Parses one string into T, the same conversion TRY_CAST(x AS T) performs
+template <class T>
+static inline bool TryParseNumber(string_t input, T &result) {
+	return TryCast::Operation<string_t, T>(input, result, false);
+}
+
+//! toXOrZero / toXOrNull over strings: every value is parsed exactly once. Unparseable values become NULL, or 0
+//! with OR_ZERO, which like the former CASE WHEN TRY_CAST(..) IS NOT NULL macros also turns NULL input into 0.
+template <class T, bool OR_ZERO>
+static void ParseNumberOrDefault(Vector &input, Vector &result, idx_t count) {
+	if (input.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+		auto result_data = ConstantVector::GetData<T>(result);
+		if (!ConstantVector::IsNull(input) && TryParseNumber<T>(*ConstantVector::GetData<string_t>(input), *result_data)) {
+			return;
+		}
+		*result_data = T(0);
+		ConstantVector::SetNull(result, !OR_ZERO);
+		return;
+	}
+	UnifiedVectorFormat format;
+	input.ToUnifiedFormat(count, format);
+	const auto input_data = UnifiedVectorFormat::GetData<string_t>(format);
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_data = FlatVector::GetData<T>(result);
+	auto &result_mask = FlatVector::Validity(result);
+	for (idx_t i = 0; i < count; i++) {
+		const auto idx = format.sel->get_index(i);
+		if (format.validity.RowIsValid(idx) && TryParseNumber<T>(input_data[idx], result_data[i])) {
+			continue;
+		}
+		result_data[i] = T(0);
+		if (!OR_ZERO) {
+			result_mask.SetInvalid(i);
+		}
+	}
+}
+
+//! Non-string arguments (e.g. toInt8OrZero(-1)) go through the regular vectorized cast in non-throwing mode
+template <class T, bool OR_ZERO>
+static void CastNumberOrDefault(Vector &input, Vector &result, idx_t count, ClientContext &context) {
+	string error_message;
+	VectorOperations::TryCast(context, input, result, count, &error_message);
+	if (!OR_ZERO) {
+		return;
+	}
+	if (result.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+		if (ConstantVector::IsNull(result)) {
+			*ConstantVector::GetData<T>(result) = T(0);
+			ConstantVector::SetNull(result, false);
+		}
+		return;
+	}
+	result.Flatten(count);
+	auto &result_mask = FlatVector::Validity(result);
+	if (result_mask.AllValid()) {
+		return;
+	}
+	auto result_data = FlatVector::GetData<T>(result);
+	for (idx_t i = 0; i < count; i++) {
+		if (!result_mask.RowIsValid(i)) {
+			result_data[i] = T(0);
+		}
+	}
+	result_mask.SetAllValid(count);
+}
+
+template <class T, bool OR_ZERO>
+static void ToNumberOrDefaultFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &input = args.data[0];
+	if (input.GetType().id() == LogicalTypeId::VARCHAR) {
+		ParseNumberOrDefault<T, OR_ZERO>(input, result, args.size());
+	} else {
+		CastNumberOrDefault<T, OR_ZERO>(input, result, args.size(), state.GetContext());
+	}
+}
+
+template <class T>
+static void RegisterConversion(DatabaseInstance &instance, const string &name, const LogicalType &type) {
+	ScalarFunction or_zero(name + "OrZero", {LogicalType::ANY}, type, ToNumberOrDefaultFunction<T, true>);
+	or_zero.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+	ExtensionUtil::RegisterFunction(instance, or_zero);
+	ExtensionUtil::RegisterFunction(
+	    instance, ScalarFunction(name + "OrNull", {LogicalType::ANY}, type, ToNumberOrDefaultFunction<T, false>));
+}
+
+void RegisterConversionFunctions(DatabaseInstance &instance) {
+	RegisterConversion<int8_t>(instance, "toInt8", LogicalType::TINYINT);
+	RegisterConversion<int16_t>(instance, "toInt16", LogicalType::SMALLINT);
+	RegisterConversion<int32_t>(instance, "toInt32", LogicalType::INTEGER);
+	RegisterConversion<int64_t>(instance, "toInt64", LogicalType::BIGINT);
+	RegisterConversion<hugeint_t>(instance, "toInt128", LogicalType::HUGEINT);
+	RegisterConversion<hugeint_t>(instance, "toInt256", LogicalType::HUGEINT);
+	RegisterConversion<uint8_t>(instance, "toUInt8", LogicalType::UTINYINT);
+	RegisterConversion<uint16_t>(instance, "toUInt16", LogicalType::USMALLINT);
+	RegisterConversion<uint32_t>(instance, "toUInt32", LogicalType::UINTEGER);
+	RegisterConversion<uint64_t>(instance, "toUInt64", LogicalType::UBIGINT);
+	RegisterConversion<double>(instance, "toFloat", LogicalType::DOUBLE);
+}
+
+} // namespace duckdb
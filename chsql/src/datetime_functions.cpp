@@ -0,0 +1,916 @@
+#include "datetime_functions.hpp"
+#include "duckdb/common/error_data.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/date.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/common/vector_operations/binary_executor.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/function_binder.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// Calendar arithmetic
+//===--------------------------------------------------------------------===//
+
+static constexpr int64_t MICROS_PER_SECOND = 1000000;
+static constexpr int64_t MICROS_PER_MINUTE = 60 * MICROS_PER_SECOND;
+static constexpr int64_t MICROS_PER_HOUR = 60 * MICROS_PER_MINUTE;
+static constexpr int64_t MICROS_PER_DAY = 24 * MICROS_PER_HOUR;
+//! 1970-01-05, the first Monday after the epoch: week buckets start on Mondays as in ClickHouse
+static constexpr int64_t FIRST_MONDAY = 4;
+
+static inline int64_t FloorDiv(int64_t value, int64_t divisor) {
+	const auto quotient = value / divisor;
+	return quotient - (value % divisor < 0);
+}
+
+//! A date or timestamp split into days since the epoch and the microseconds into that day
+struct DayTime {
+	int64_t days;
+	int64_t micros;
+};
+
+static inline DayTime SplitTime(date_t date) {
+	return {date.days, 0};
+}
+
+static inline DayTime SplitTime(timestamp_t ts) {
+	const auto days = FloorDiv(ts.value, MICROS_PER_DAY);
+	return {days, ts.value - days * MICROS_PER_DAY};
+}
+
+static inline bool IsFiniteTime(date_t date) {
+	return Date::IsFinite(date);
+}
+
+static inline bool IsFiniteTime(timestamp_t ts) {
+	return Timestamp::IsFinite(ts);
+}
+
+//! Proleptic Gregorian civil date of a day number, the days_from_civil/civil_from_days algorithms by Howard Hinnant
+struct CivilDate {
+	int64_t year;
+	uint32_t month;
+	uint32_t day;
+};
+
+static inline CivilDate CivilFromDays(int64_t days) {
+	days += 719468;
+	const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	const auto doe = uint32_t(days - era * 146097);
+	const auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const auto mp = (5 * doy + 2) / 153;
+	const auto month = mp < 10 ? mp + 3 : mp - 9;
+	return {int64_t(yoe) + era * 400 + (month <= 2), month, doy - (153 * mp + 2) / 5 + 1};
+}
+
+static inline int64_t DaysFromCivil(int64_t year, uint32_t month, uint32_t day) {
+	year -= month <= 2;
+	const int64_t era = (year >= 0 ? year : year - 399) / 400;
+	const auto yoe = uint32_t(year - era * 400);
+	const auto doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	const auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + int64_t(doe) - 719468;
+}
+
+//===--------------------------------------------------------------------===//
+// Time zones
+//===--------------------------------------------------------------------===//
+
+//! Parses UTC, GMT, Z, Etc/UTC, +03:00, -0830, UTC+3 and Etc/GMT-3 (POSIX sign, i.e. UTC+3) into an offset east
+//! of UTC. Zones with daylight saving time need a timezone database and are not fixed offsets.
+static bool TryParseFixedOffset(const string &zone_p, int64_t &offset_micros) {
+	auto zone = StringUtil::Lower(zone_p);
+	bool posix_sign = false;
+	if (StringUtil::StartsWith(zone, "etc/")) {
+		zone = zone.substr(4);
+		posix_sign = true;
+	}
+	if (zone == "z") {
+		zone.clear();
+	} else if (StringUtil::StartsWith(zone, "utc") || StringUtil::StartsWith(zone, "gmt")) {
+		zone = zone.substr(3);
+	} else {
+		posix_sign = false;
+	}
+	offset_micros = 0;
+	if (zone.empty()) {
+		return true;
+	}
+	if (zone[0] != '+' && zone[0] != '-') {
+		return false;
+	}
+	int64_t digits[4];
+	idx_t count = 0;
+	for (idx_t i = 1; i < zone.size(); i++) {
+		if (zone[i] == ':' && (count == 1 || count == 2)) {
+			if (count == 1) {
+				digits[1] = digits[0];
+				digits[0] = 0;
+				count = 2;
+			}
+			continue;
+		}
+		if (!StringUtil::CharacterIsDigit(zone[i]) || count == 4) {
+			return false;
+		}
+		digits[count++] = zone[i] - '0';
+	}
+	int64_t hours;
+	int64_t minutes = 0;
+	switch (count) {
+	case 1:
+		hours = digits[0];
+		break;
+	case 2:
+		hours = digits[0] * 10 + digits[1];
+		break;
+	case 4:
+		hours = digits[0] * 10 + digits[1];
+		minutes = digits[2] * 10 + digits[3];
+		break;
+	default:
+		return false;
+	}
+	if (hours > 18 || minutes > 59) {
+		return false;
+	}
+	const auto sign = (zone[0] == '-') != posix_sign ? -1 : 1;
+	offset_micros = sign * (hours * MICROS_PER_HOUR + minutes * MICROS_PER_MINUTE);
+	return true;
+}
+
+static unique_ptr<Expression> BindTimezoneCall(ClientContext &context, const string &name, unique_ptr<Expression> zone,
+                                               unique_ptr<Expression> time) {
+	vector<unique_ptr<Expression>> children;
+	children.push_back(std::move(zone));
+	children.push_back(std::move(time));
+	ErrorData error;
+	FunctionBinder binder(context);
+	auto result = binder.BindScalarFunction(DEFAULT_SCHEMA, "timezone", std::move(children), error);
+	if (!result) {
+		error.Throw(name + ": named timezones need the timezone function of the icu extension: ");
+	}
+	return result;
+}
+
+//! The session TimeZone setting, which the icu extension defines. Without it TIMESTAMPTZ values are in UTC.
+static string SessionTimeZone(ClientContext &context) {
+	Value zone;
+	if (context.TryGetCurrentSetting("TimeZone", zone) && !zone.IsNull()) {
+		return zone.ToString();
+	}
+	return "UTC";
+}
+
+//! How a TIMESTAMPTZ argument reaches the session's wall clock: a fixed-offset zone is an offset added to the
+//! input, any other zone rewrote the argument to timezone(zone, time), a TIMESTAMP holding the wall clock.
+struct SessionZone {
+	string zone;
+	bool fixed_offset = true;
+	int64_t offset_micros = 0;
+};
+
+//! Binds the first argument in the session TimeZone when it is a TIMESTAMPTZ, as ClickHouse evaluates DateTime
+//! functions in the server timezone. Other arguments are left alone.
+static SessionZone BindSessionZone(ClientContext &context, const string &name, ScalarFunction &bound_function,
+                                   vector<unique_ptr<Expression>> &arguments) {
+	SessionZone result;
+	if (bound_function.arguments[0].id() != LogicalTypeId::TIMESTAMP_TZ) {
+		return result;
+	}
+	result.zone = SessionTimeZone(context);
+	if (TryParseFixedOffset(result.zone, result.offset_micros)) {
+		return result;
+	}
+	result.fixed_offset = false;
+	arguments[0] = BindTimezoneCall(context, name, make_uniq<BoundConstantExpression>(Value(result.zone)),
+	                                std::move(arguments[0]));
+	bound_function.arguments[0] = arguments[0]->return_type;
+	return result;
+}
+
+static inline date_t ShiftTime(date_t date, int64_t offset_micros) {
+	return date;
+}
+
+static inline timestamp_t ShiftTime(timestamp_t ts, int64_t offset_micros) {
+	return timestamp_t(ts.value + offset_micros);
+}
+
+//===--------------------------------------------------------------------===//
+// toYYYYMM, toYYYYMMDD, toYYYYMMDDhhmmss
+//===--------------------------------------------------------------------===//
+
+struct ToYYYYMM {
+	using RESULT = uint32_t;
+	static constexpr int64_t MAX_YEAR = 42949672;
+	static RESULT Operation(const CivilDate &date, int64_t micros) {
+		return RESULT(date.year * 100 + date.month);
+	}
+};
+
+struct ToYYYYMMDD {
+	using RESULT = uint32_t;
+	static constexpr int64_t MAX_YEAR = 429496;
+	static RESULT Operation(const CivilDate &date, int64_t micros) {
+		return RESULT((date.year * 100 + date.month) * 100 + date.day);
+	}
+};
+
+struct ToYYYYMMDDhhmmss {
+	using RESULT = uint64_t;
+	static constexpr int64_t MAX_YEAR = 1844674407;
+	static RESULT Operation(const CivilDate &date, int64_t micros) {
+		const auto seconds = micros / MICROS_PER_SECOND;
+		const auto hhmmss = (seconds / 3600) * 10000 + (seconds / 60 % 60) * 100 + seconds % 60;
+		return RESULT(((date.year * 100 + date.month) * 100 + date.day) * 1000000 + hhmmss);
+	}
+};
+
+struct PackedDateBindData : FunctionData {
+	explicit PackedDateBindData(int64_t offset_micros_p) : offset_micros(offset_micros_p) {
+	}
+
+	//! Offset of a fixed-offset session zone, added to TIMESTAMPTZ inputs
+	int64_t offset_micros;
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<PackedDateBindData>(offset_micros);
+	}
+	bool Equals(const FunctionData &other_p) const override {
+		return offset_micros == other_p.Cast<PackedDateBindData>().offset_micros;
+	}
+};
+
+static unique_ptr<FunctionData> PackedDateBind(ClientContext &context, ScalarFunction &bound_function,
+                                               vector<unique_ptr<Expression>> &arguments) {
+	const auto zone = BindSessionZone(context, bound_function.name, bound_function, arguments);
+	return make_uniq<PackedDateBindData>(zone.offset_micros);
+}
+
+//! Infinite values and years before 0 or too large to pack into the result type (OP::MAX_YEAR) are NULL
+template <class INPUT, class OP>
+static void PackedDateFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	using RESULT = typename OP::RESULT;
+	auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+	const auto offset_micros = func_expr.bind_info->Cast<PackedDateBindData>().offset_micros;
+	UnaryExecutor::ExecuteWithNulls<INPUT, RESULT>(
+	    args.data[0], result, args.size(), [&](INPUT input, ValidityMask &mask, idx_t idx) {
+		    if (!IsFiniteTime(input)) {
+			    mask.SetInvalid(idx);
+			    return RESULT(0);
+		    }
+		    const auto time = SplitTime(ShiftTime(input, offset_micros));
+		    const auto date = CivilFromDays(time.days);
+		    if (date.year < 0 || date.year > OP::MAX_YEAR) {
+			    mask.SetInvalid(idx);
+			    return RESULT(0);
+		    }
+		    return OP::Operation(date, time.micros);
+	    });
+}
+
+//! TIMESTAMPTZ values are packed in the session TimeZone
+template <class OP>
+static ScalarFunctionSet PackedDateFunctionSet(const string &name, const LogicalType &result_type) {
+	ScalarFunctionSet set(name);
+	set.AddFunction(ScalarFunction({LogicalType::DATE}, result_type, PackedDateFunction<date_t, OP>,
+	                               PackedDateBind));
+	set.AddFunction(ScalarFunction({LogicalType::TIMESTAMP}, result_type, PackedDateFunction<timestamp_t, OP>,
+	                               PackedDateBind));
+	set.AddFunction(ScalarFunction({LogicalType::TIMESTAMP_TZ}, result_type, PackedDateFunction<timestamp_t, OP>,
+	                               PackedDateBind));
+	return set;
+}
+
+//===--------------------------------------------------------------------===//
+// toStartOfInterval, toStartOfHour, ...
+//===--------------------------------------------------------------------===//
+
+//! A bucket width: whole months, whole days or microseconds, as ClickHouse intervals never mix units
+struct BucketWidth {
+	int64_t months = 0;
+	int64_t days = 0;
+	int64_t micros = 0;
+
+	bool operator==(const BucketWidth &other) const {
+		return months == other.months && days == other.days && micros == other.micros;
+	}
+};
+
+struct BucketBindData : FunctionData {
+	explicit BucketBindData(BucketWidth width_p) : width(width_p) {
+	}
+
+	BucketWidth width;
+	//! Offset of a fixed-offset session zone: TIMESTAMPTZ inputs are bucketed on the wall clock of that zone
+	int64_t offset_micros = 0;
+	//! Named session zones: timezone(zone, #0), turning the bucketed wall clock back into an instant
+	unique_ptr<Expression> to_instant;
+
+	unique_ptr<FunctionData> Copy() const override {
+		auto res = make_uniq<BucketBindData>(width);
+		res->offset_micros = offset_micros;
+		res->to_instant = to_instant ? to_instant->Copy() : nullptr;
+		return std::move(res);
+	}
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<BucketBindData>();
+		return width == other.width && offset_micros == other.offset_micros &&
+		       (to_instant ? other.to_instant && to_instant->Equals(*other.to_instant) : !other.to_instant);
+	}
+};
+
+//! First day of the bucket holding a day, months count from 1970-01 and weeks from Monday 1970-01-05
+static inline int64_t BucketStartDay(int64_t days, const BucketWidth &width) {
+	if (width.months > 0) {
+		const auto date = CivilFromDays(days);
+		const auto months = (date.year - 1970) * 12 + int64_t(date.month) - 1;
+		const auto start = FloorDiv(months, width.months) * width.months;
+		const auto year = 1970 + FloorDiv(start, 12);
+		return DaysFromCivil(year, uint32_t(start - (year - 1970) * 12 + 1), 1);
+	}
+	const auto origin = width.days % 7 == 0 ? FIRST_MONDAY : 0;
+	return FloorDiv(days - origin, width.days) * width.days + origin;
+}
+
+static inline date_t BucketStart(date_t date, const BucketWidth &width) {
+	return date_t(int32_t(BucketStartDay(date.days, width)));
+}
+
+static inline timestamp_t BucketStart(timestamp_t ts, const BucketWidth &width) {
+	if (width.micros > 0) {
+		return timestamp_t(FloorDiv(ts.value, width.micros) * width.micros);
+	}
+	return timestamp_t(BucketStartDay(SplitTime(ts).days, width) * MICROS_PER_DAY);
+}
+
+//! Infinite values are their own bucket
+template <class T>
+static void BucketFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+	auto &info = func_expr.bind_info->Cast<BucketBindData>();
+	const auto width = info.width;
+	const auto offset_micros = info.offset_micros;
+	UnaryExecutor::Execute<T, T>(args.data[0], result, args.size(), [&](T input) {
+		return IsFiniteTime(input) ? ShiftTime(BucketStart(ShiftTime(input, offset_micros), width), -offset_micros)
+		                           : input;
+	});
+}
+
+struct ZonedBucketLocalState : FunctionLocalState {
+	ZonedBucketLocalState(ClientContext &context, const Expression &to_instant) : executor(context, to_instant) {
+		wall_clock.Initialize(context, {LogicalType::TIMESTAMP});
+	}
+
+	ExpressionExecutor executor;
+	DataChunk wall_clock;
+};
+
+static unique_ptr<FunctionLocalState> ZonedBucketInitLocal(ExpressionState &state, const BoundFunctionExpression &expr,
+                                                           FunctionData *bind_data) {
+	return make_uniq<ZonedBucketLocalState>(state.GetContext(), *bind_data->Cast<BucketBindData>().to_instant);
+}
+
+//! TIMESTAMPTZ buckets in a named session zone: the argument is the wall clock timezone(zone, time), its bucket
+//! start becomes an instant again through timezone(zone, start)
+static void ZonedBucketFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &local = ExecuteFunctionState::GetFunctionState(state)->Cast<ZonedBucketLocalState>();
+	local.wall_clock.Reset();
+	BucketFunction<timestamp_t>(args, state, local.wall_clock.data[0]);
+	local.wall_clock.SetCardinality(args.size());
+	local.executor.ExecuteExpression(local.wall_clock, result);
+}
+
+//! Buckets TIMESTAMPTZ arguments on the wall clock of the session TimeZone, as ClickHouse does in the server
+//! timezone. Days, weeks and months then start at local midnight.
+static unique_ptr<FunctionData> BindBucketZone(ClientContext &context, ScalarFunction &bound_function,
+                                               vector<unique_ptr<Expression>> &arguments, BucketWidth width) {
+	auto res = make_uniq<BucketBindData>(width);
+	const auto zone = BindSessionZone(context, bound_function.name, bound_function, arguments);
+	res->offset_micros = zone.offset_micros;
+	if (!zone.fixed_offset) {
+		res->to_instant = BindTimezoneCall(context, bound_function.name,
+		                                   make_uniq<BoundConstantExpression>(Value(zone.zone)),
+		                                   make_uniq<BoundReferenceExpression>(LogicalType::TIMESTAMP, 0));
+		bound_function.function = ZonedBucketFunction;
+		bound_function.init_local_state = ZonedBucketInitLocal;
+	}
+	return std::move(res);
+}
+
+template <int64_t WIDTH>
+static unique_ptr<FunctionData> FixedBucketBind(ClientContext &context, ScalarFunction &bound_function,
+                                                vector<unique_ptr<Expression>> &arguments) {
+	BucketWidth width;
+	width.micros = WIDTH;
+	return BindBucketZone(context, bound_function, arguments, width);
+}
+
+static unique_ptr<FunctionData> IntervalBucketBind(ClientContext &context, ScalarFunction &bound_function,
+                                                   vector<unique_ptr<Expression>> &arguments) {
+	if (!arguments[1]->IsFoldable()) {
+		throw BinderException("toStartOfInterval: the interval must be a constant");
+	}
+	const auto value = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+	if (value.IsNull()) {
+		throw BinderException("toStartOfInterval: the interval must not be NULL");
+	}
+	const auto interval = value.GetValue<interval_t>();
+	BucketWidth width;
+	width.months = interval.months;
+	width.days = interval.days;
+	width.micros = interval.micros;
+	const auto units = (width.months != 0) + (width.days != 0) + (width.micros != 0);
+	if (units != 1 || width.months < 0 || width.days < 0 || width.micros < 0) {
+		throw BinderException("toStartOfInterval: the interval must be positive and of a single unit, e.g. "
+		                      "INTERVAL 15 MINUTE");
+	}
+	if (width.micros > 0 && bound_function.arguments[0].id() == LogicalTypeId::DATE) {
+		throw BinderException("toStartOfInterval: a DATE can only be bucketed by days, weeks, months or years");
+	}
+	Function::EraseArgument(bound_function, arguments, 1);
+	return BindBucketZone(context, bound_function, arguments, width);
+}
+
+template <int64_t WIDTH>
+static ScalarFunctionSet FixedBucketFunctionSet(const string &name) {
+	ScalarFunctionSet set(name);
+	set.AddFunction(ScalarFunction({LogicalType::TIMESTAMP}, LogicalType::TIMESTAMP, BucketFunction<timestamp_t>,
+	                               FixedBucketBind<WIDTH>));
+	set.AddFunction(ScalarFunction({LogicalType::TIMESTAMP_TZ}, LogicalType::TIMESTAMP_TZ,
+	                               BucketFunction<timestamp_t>, FixedBucketBind<WIDTH>));
+	return set;
+}
+
+static ScalarFunctionSet IntervalBucketFunctionSet() {
+	ScalarFunctionSet set("toStartOfInterval");
+	set.AddFunction(ScalarFunction({LogicalType::DATE, LogicalType::INTERVAL}, LogicalType::DATE,
+	                               BucketFunction<date_t>, IntervalBucketBind));
+	set.AddFunction(ScalarFunction({LogicalType::TIMESTAMP, LogicalType::INTERVAL}, LogicalType::TIMESTAMP,
+	                               BucketFunction<timestamp_t>, IntervalBucketBind));
+	set.AddFunction(ScalarFunction({LogicalType::TIMESTAMP_TZ, LogicalType::INTERVAL}, LogicalType::TIMESTAMP_TZ,
+	                               BucketFunction<timestamp_t>, IntervalBucketBind));
+	return set;
+}
+
+//===--------------------------------------------------------------------===//
+// formatDateTime
+//===--------------------------------------------------------------------===//
+
+enum class DateTimeField : uint8_t {
+	LITERAL,
+	YEAR,
+	YEAR_2,
+	CENTURY,
+	QUARTER,
+	MONTH,
+	MONTH_ABBR,
+	MONTH_NAME,
+	DAY,
+	DAY_SPACE,
+	DAY_OF_YEAR,
+	WEEKDAY_ISO,
+	WEEKDAY_SUNDAY_0,
+	WEEKDAY_ABBR,
+	WEEKDAY_NAME,
+	HOUR,
+	HOUR_SPACE,
+	HOUR_12,
+	HOUR_12_SPACE,
+	AM_PM,
+	MINUTE,
+	SECOND,
+	MICROSECOND,
+	OFFSET
+};
+
+struct FormatToken {
+	DateTimeField field;
+	string literal;
+
+	bool operator==(const FormatToken &other) const {
+		return field == other.field && literal == other.literal;
+	}
+};
+
+static const char *const MONTH_NAMES[] = {"January", "February", "March",     "April",   "May",      "June",
+                                          "July",    "August",   "September", "October", "November", "December"};
+static const char *const WEEKDAY_NAMES[] = {"Sunday",   "Monday", "Tuesday", "Wednesday",
+                                            "Thursday", "Friday", "Saturday"};
+
+static void AddField(vector<FormatToken> &tokens, DateTimeField field) {
+	tokens.push_back(FormatToken {field, string()});
+}
+
+static void AddLiteral(vector<FormatToken> &tokens, const string &text) {
+	if (!tokens.empty() && tokens.back().field == DateTimeField::LITERAL) {
+		tokens.back().literal += text;
+	} else {
+		tokens.push_back(FormatToken {DateTimeField::LITERAL, text});
+	}
+}
+
+//! Splits a format into literals and fields once, rows only walk the tokens. The specifiers are ClickHouse's,
+//! except that %M stays the minute as in strftime and the former strftime-based macro.
+static vector<FormatToken> CompileFormat(const string &format) {
+	vector<FormatToken> tokens;
+	for (idx_t i = 0; i < format.size(); i++) {
+		if (format[i] != '%') {
+			AddLiteral(tokens, string(1, format[i]));
+			continue;
+		}
+		if (++i == format.size()) {
+			throw InvalidInputException("formatDateTime: format ends with a lone '%'");
+		}
+		switch (format[i]) {
+		case 'Y':
+			AddField(tokens, DateTimeField::YEAR);
+			break;
+		case 'y':
+			AddField(tokens, DateTimeField::YEAR_2);
+			break;
+		case 'C':
+			AddField(tokens, DateTimeField::CENTURY);
+			break;
+		case 'Q':
+			AddField(tokens, DateTimeField::QUARTER);
+			break;
+		case 'm':
+		case 'c':
+			AddField(tokens, DateTimeField::MONTH);
+			break;
+		case 'b':
+			AddField(tokens, DateTimeField::MONTH_ABBR);
+			break;
+		case 'B':
+			AddField(tokens, DateTimeField::MONTH_NAME);
+			break;
+		case 'd':
+			AddField(tokens, DateTimeField::DAY);
+			break;
+		case 'e':
+			AddField(tokens, DateTimeField::DAY_SPACE);
+			break;
+		case 'j':
+			AddField(tokens, DateTimeField::DAY_OF_YEAR);
+			break;
+		case 'u':
+			AddField(tokens, DateTimeField::WEEKDAY_ISO);
+			break;
+		case 'w':
+			AddField(tokens, DateTimeField::WEEKDAY_SUNDAY_0);
+			break;
+		case 'a':
+			AddField(tokens, DateTimeField::WEEKDAY_ABBR);
+			break;
+		case 'A':
+			AddField(tokens, DateTimeField::WEEKDAY_NAME);
+			break;
+		case 'H':
+			AddField(tokens, DateTimeField::HOUR);
+			break;
+		case 'k':
+			AddField(tokens, DateTimeField::HOUR_SPACE);
+			break;
+		case 'I':
+		case 'h':
+			AddField(tokens, DateTimeField::HOUR_12);
+			break;
+		case 'l':
+			AddField(tokens, DateTimeField::HOUR_12_SPACE);
+			break;
+		case 'p':
+			AddField(tokens, DateTimeField::AM_PM);
+			break;
+		case 'M':
+		case 'i':
+			AddField(tokens, DateTimeField::MINUTE);
+			break;
+		case 'S':
+		case 's':
+			AddField(tokens, DateTimeField::SECOND);
+			break;
+		case 'f':
+			AddField(tokens, DateTimeField::MICROSECOND);
+			break;
+		case 'z':
+			AddField(tokens, DateTimeField::OFFSET);
+			break;
+		case 'F':
+			tokens = CompileFormat(format.substr(0, i - 1) + "%Y-%m-%d" + format.substr(i + 1));
+			return tokens;
+		case 'T':
+			tokens = CompileFormat(format.substr(0, i - 1) + "%H:%M:%S" + format.substr(i + 1));
+			return tokens;
+		case 'D':
+			tokens = CompileFormat(format.substr(0, i - 1) + "%m/%d/%y" + format.substr(i + 1));
+			return tokens;
+		case 'R':
+			tokens = CompileFormat(format.substr(0, i - 1) + "%H:%M" + format.substr(i + 1));
+			return tokens;
+		case 'r':
+			tokens = CompileFormat(format.substr(0, i - 1) + "%I:%M %p" + format.substr(i + 1));
+			return tokens;
+		case 'n':
+			AddLiteral(tokens, "\n");
+			break;
+		case 't':
+			AddLiteral(tokens, "\t");
+			break;
+		case '%':
+			AddLiteral(tokens, "%");
+			break;
+		default:
+			throw InvalidInputException("formatDateTime: unsupported format specifier '%%%s'", string(1, format[i]));
+		}
+	}
+	return tokens;
+}
+
+static inline void AppendPadded(string &out, int64_t value, idx_t width, char pad = '0') {
+	if (value < 0) {
+		out += '-';
+		value = -value;
+	}
+	char digits[24];
+	idx_t count = 0;
+	do {
+		digits[count++] = char('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	for (; count < width; width--) {
+		out += pad;
+	}
+	while (count > 0) {
+		out += digits[--count];
+	}
+}
+
+static void FormatTime(string &out, const vector<FormatToken> &tokens, timestamp_t ts, int64_t offset_micros) {
+	const auto time = SplitTime(ts);
+	const auto date = CivilFromDays(time.days);
+	const auto hour = time.micros / MICROS_PER_HOUR;
+	const auto weekday = (time.days % 7 + 11) % 7;
+	for (auto &token : tokens) {
+		switch (token.field) {
+		case DateTimeField::LITERAL:
+			out += token.literal;
+			break;
+		case DateTimeField::YEAR:
+			AppendPadded(out, date.year, 4);
+			break;
+		case DateTimeField::YEAR_2:
+			AppendPadded(out, (date.year % 100 + 100) % 100, 2);
+			break;
+		case DateTimeField::CENTURY:
+			AppendPadded(out, FloorDiv(date.year, 100), 2);
+			break;
+		case DateTimeField::QUARTER:
+			AppendPadded(out, (date.month - 1) / 3 + 1, 1);
+			break;
+		case DateTimeField::MONTH:
+			AppendPadded(out, date.month, 2);
+			break;
+		case DateTimeField::MONTH_ABBR:
+			out.append(MONTH_NAMES[date.month - 1], 3);
+			break;
+		case DateTimeField::MONTH_NAME:
+			out += MONTH_NAMES[date.month - 1];
+			break;
+		case DateTimeField::DAY:
+			AppendPadded(out, date.day, 2);
+			break;
+		case DateTimeField::DAY_SPACE:
+			AppendPadded(out, date.day, 2, ' ');
+			break;
+		case DateTimeField::DAY_OF_YEAR:
+			AppendPadded(out, time.days - DaysFromCivil(date.year, 1, 1) + 1, 3);
+			break;
+		case DateTimeField::WEEKDAY_ISO:
+			AppendPadded(out, weekday == 0 ? 7 : weekday, 1);
+			break;
+		case DateTimeField::WEEKDAY_SUNDAY_0:
+			AppendPadded(out, weekday, 1);
+			break;
+		case DateTimeField::WEEKDAY_ABBR:
+			out.append(WEEKDAY_NAMES[weekday], 3);
+			break;
+		case DateTimeField::WEEKDAY_NAME:
+			out += WEEKDAY_NAMES[weekday];
+			break;
+		case DateTimeField::HOUR:
+			AppendPadded(out, hour, 2);
+			break;
+		case DateTimeField::HOUR_SPACE:
+			AppendPadded(out, hour, 2, ' ');
+			break;
+		case DateTimeField::HOUR_12:
+			AppendPadded(out, (hour + 11) % 12 + 1, 2);
+			break;
+		case DateTimeField::HOUR_12_SPACE:
+			AppendPadded(out, (hour + 11) % 12 + 1, 2, ' ');
+			break;
+		case DateTimeField::AM_PM:
+			out += hour < 12 ? "AM" : "PM";
+			break;
+		case DateTimeField::MINUTE:
+			AppendPadded(out, time.micros / MICROS_PER_MINUTE % 60, 2);
+			break;
+		case DateTimeField::SECOND:
+			AppendPadded(out, time.micros / MICROS_PER_SECOND % 60, 2);
+			break;
+		case DateTimeField::MICROSECOND:
+			AppendPadded(out, time.micros % MICROS_PER_SECOND, 6);
+			break;
+		case DateTimeField::OFFSET: {
+			const auto minutes = offset_micros / MICROS_PER_MINUTE;
+			out += minutes < 0 ? '-' : '+';
+			AppendPadded(out, (minutes < 0 ? -minutes : minutes) / 60, 2);
+			AppendPadded(out, (minutes < 0 ? -minutes : minutes) % 60, 2);
+			break;
+		}
+		}
+	}
+}
+
+struct FormatDateTimeBindData : FunctionData {
+	//! The compiled format when it is a constant
+	bool constant_format = false;
+	vector<FormatToken> tokens;
+	//! Shift from the input to the wall clock of a fixed-offset zone. False when DuckDB's timezone function
+	//! already converted the input, its offset is then unknown to %z.
+	bool fixed_offset = true;
+	int64_t offset_micros = 0;
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<FormatDateTimeBindData>(*this);
+	}
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<FormatDateTimeBindData>();
+		return constant_format == other.constant_format && tokens == other.tokens &&
+		       fixed_offset == other.fixed_offset && offset_micros == other.offset_micros;
+	}
+};
+
+static bool HasOffsetField(const vector<FormatToken> &tokens) {
+	for (auto &token : tokens) {
+		if (token.field == DateTimeField::OFFSET) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//! formatDateTime(time, format[, timezone]). A constant format is compiled here. A constant fixed-offset timezone
+//! becomes a shift of the input. Any other timezone is converted by DuckDB's timezone function (icu) ahead of the
+//! formatting, a vector at a time: timezone(zone, time AT UTC) is the wall clock of the instant in that zone.
+//! TIMESTAMPTZ values without a timezone (or a NULL one) are formatted in the session TimeZone.
+static unique_ptr<FunctionData> FormatDateTimeBind(ClientContext &context, ScalarFunction &bound_function,
+                                                   vector<unique_ptr<Expression>> &arguments) {
+	auto res = make_uniq<FormatDateTimeBindData>();
+	if (arguments[1]->IsFoldable()) {
+		const auto format = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+		if (!format.IsNull()) {
+			res->constant_format = true;
+			res->tokens = CompileFormat(StringValue::Get(format.DefaultCastAs(LogicalType::VARCHAR)));
+		}
+	}
+	const auto time_type = bound_function.arguments[0].id();
+	if (arguments.size() == 3 && time_type == LogicalTypeId::DATE) {
+		// dates carry no time of day to shift
+		Function::EraseArgument(bound_function, arguments, 2);
+		return std::move(res);
+	}
+	if (arguments.size() == 3 && arguments[2]->IsFoldable()) {
+		const auto zone = ExpressionExecutor::EvaluateScalar(context, *arguments[2]);
+		if (zone.IsNull()) {
+			Function::EraseArgument(bound_function, arguments, 2);
+		} else if (TryParseFixedOffset(StringValue::Get(zone.DefaultCastAs(LogicalType::VARCHAR)),
+		                               res->offset_micros)) {
+			Function::EraseArgument(bound_function, arguments, 2);
+			return std::move(res);
+		}
+	}
+	if (arguments.size() < 3) {
+		// without a timezone TIMESTAMPTZ values are shown in the session TimeZone
+		const auto zone = BindSessionZone(context, bound_function.name, bound_function, arguments);
+		res->fixed_offset = zone.fixed_offset;
+		res->offset_micros = zone.offset_micros;
+		if (!res->fixed_offset && res->constant_format && HasOffsetField(res->tokens)) {
+			throw BinderException("formatDateTime: %z needs a fixed-offset timezone such as '+03:00'");
+		}
+		return std::move(res);
+	}
+	if (res->constant_format && HasOffsetField(res->tokens)) {
+		throw BinderException("formatDateTime: %z needs a fixed-offset timezone such as '+03:00'");
+	}
+	res->fixed_offset = false;
+	auto zone = std::move(arguments[2]);
+	Function::EraseArgument(bound_function, arguments, 2);
+	auto time = std::move(arguments[0]);
+	if (time_type == LogicalTypeId::TIMESTAMP) {
+		time = BindTimezoneCall(context, "formatDateTime", make_uniq<BoundConstantExpression>(Value("UTC")),
+		                        std::move(time));
+	}
+	arguments[0] = BindTimezoneCall(context, "formatDateTime", std::move(zone), std::move(time));
+	bound_function.arguments[0] = arguments[0]->return_type;
+	return std::move(res);
+}
+
+template <class T>
+static inline timestamp_t ToTimestamp(T input);
+
+template <>
+inline timestamp_t ToTimestamp(date_t input) {
+	return timestamp_t(int64_t(input.days) * MICROS_PER_DAY);
+}
+
+template <>
+inline timestamp_t ToTimestamp(timestamp_t input) {
+	return input;
+}
+
+template <class T>
+static void FormatDateTimeFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+	auto &info = func_expr.bind_info->Cast<FormatDateTimeBindData>();
+	string buffer;
+	auto format_row = [&](T input, const vector<FormatToken> &tokens, ValidityMask &mask, idx_t idx) {
+		if (!IsFiniteTime(input)) {
+			mask.SetInvalid(idx);
+			return string_t();
+		}
+		buffer.clear();
+		FormatTime(buffer, tokens, timestamp_t(ToTimestamp(input).value + info.offset_micros), info.offset_micros);
+		return StringVector::AddString(result, buffer);
+	};
+	if (info.constant_format) {
+		UnaryExecutor::ExecuteWithNulls<T, string_t>(args.data[0], result, args.size(),
+		                                             [&](T input, ValidityMask &mask, idx_t idx) {
+			                                             return format_row(input, info.tokens, mask, idx);
+		                                             });
+		return;
+	}
+	// formats that vary by row are compiled again only when they change
+	string last_format;
+	vector<FormatToken> tokens;
+	bool compiled = false;
+	BinaryExecutor::ExecuteWithNulls<T, string_t, string_t>(
+	    args.data[0], args.data[1], result, args.size(), [&](T input, string_t format, ValidityMask &mask, idx_t idx) {
+		    if (!compiled || format.GetString() != last_format) {
+			    last_format = format.GetString();
+			    tokens = CompileFormat(last_format);
+			    compiled = true;
+			    if (!info.fixed_offset && HasOffsetField(tokens)) {
+				    throw InvalidInputException("formatDateTime: %z needs a fixed-offset timezone such as '+03:00'");
+			    }
+		    }
+		    return format_row(input, tokens, mask, idx);
+	    });
+}
+
+static ScalarFunctionSet FormatDateTimeFunctionSet() {
+	ScalarFunctionSet set("formatDateTime");
+	const vector<std::pair<LogicalType, scalar_function_t>> inputs {
+	    {LogicalType::DATE, FormatDateTimeFunction<date_t>},
+	    {LogicalType::TIMESTAMP, FormatDateTimeFunction<timestamp_t>},
+	    {LogicalType::TIMESTAMP_TZ, FormatDateTimeFunction<timestamp_t>}};
+	for (auto &input : inputs) {
+		set.AddFunction(
+		    ScalarFunction({input.first, LogicalType::VARCHAR}, LogicalType::VARCHAR, input.second, FormatDateTimeBind));
+		ScalarFunction with_zone({input.first, LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::VARCHAR,
+		                         input.second, FormatDateTimeBind);
+		// a NULL timezone means the default one, the binder must not fold the call to NULL
+		with_zone.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+		set.AddFunction(with_zone);
+	}
+	return set;
+}
+
+void RegisterDateTimeFunctions(DatabaseInstance &instance) {
+	ExtensionUtil::RegisterFunction(instance, PackedDateFunctionSet<ToYYYYMM>("toYYYYMM", LogicalType::UINTEGER));
+	ExtensionUtil::RegisterFunction(instance, PackedDateFunctionSet<ToYYYYMMDD>("toYYYYMMDD", LogicalType::UINTEGER));
+	ExtensionUtil::RegisterFunction(
+	    instance, PackedDateFunctionSet<ToYYYYMMDDhhmmss>("toYYYYMMDDhhmmss", LogicalType::UBIGINT));
+
+	ExtensionUtil::RegisterFunction(instance, FixedBucketFunctionSet<MICROS_PER_MINUTE>("toStartOfMinute"));
+	ExtensionUtil::RegisterFunction(instance, FixedBucketFunctionSet<5 * MICROS_PER_MINUTE>("toStartOfFiveMinutes"));
+	ExtensionUtil::RegisterFunction(instance, FixedBucketFunctionSet<5 * MICROS_PER_MINUTE>("toStartOfFiveMinute"));
+	ExtensionUtil::RegisterFunction(instance,
+	                                FixedBucketFunctionSet<15 * MICROS_PER_MINUTE>("toStartOfFifteenMinutes"));
+	ExtensionUtil::RegisterFunction(instance, FixedBucketFunctionSet<MICROS_PER_HOUR>("toStartOfHour"));
+	ExtensionUtil::RegisterFunction(instance, IntervalBucketFunctionSet());
+	ExtensionUtil::RegisterFunction(instance, FormatDateTimeFunctionSet());
+}
+
+} // namespace duckdb
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers the native ClickHouse aggregates (uniq, uniqCombined, quantileTDigest, topK, groupArray) with their -If
+//! variants, argMaxIf and argMinIf next to core's argMax/argMin, and the -State/-Merge pairs of the mergeable sketches
+void RegisterAggregateFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers ch_scan(query, server), which streams a ClickHouse HTTP query result in RowBinaryWithNamesAndTypes,
+//! and read_ch_rowbinary(path), which decodes the same format from any file DuckDB can open
+void RegisterClickHouseScan(DatabaseInstance &instance);
+
+} // namespace duckdb
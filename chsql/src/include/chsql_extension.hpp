@@ -11,5 +11,8 @@ public:
         std::string Version() const override;
 };
 duckdb::TableFunction ReadParquetOrderedFunction();
-static void RegisterSillyBTreeStore(DatabaseInstance &instance);
+//! Compacts Parquet parts into sorted files with disjoint key ranges by streaming the read_parquet_mergetree merge
+duckdb::TableFunction MergeTreeCompactFunction();
+//! Registers tree_append, tree_get and tree_range_scan over the in-memory ordered key/value store
+void RegisterSillyBTreeStore(DatabaseInstance &instance);
 } // namespace duckdb
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers the native toXOrZero/toXOrNull conversion functions
+void RegisterConversionFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
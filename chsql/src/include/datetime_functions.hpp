@@ -0,0 +1,11 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers the native date and time functions (toYYYYMM, toYYYYMMDD, toYYYYMMDDhhmmss, toStartOfInterval,
+//! toStartOfHour, toStartOfFiveMinutes, ..., formatDateTime)
+void RegisterDateTimeFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
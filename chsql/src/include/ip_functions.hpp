@@ -0,0 +1,10 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers the native IPv4/IPv6 conversion functions
+void RegisterIPFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers the numbers(N) / numbers(offset, N) table function and its parallel variant numbers_mt
+void RegisterNumbersFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
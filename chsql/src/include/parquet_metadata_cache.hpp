@@ -0,0 +1,17 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "parquet_reader.hpp"
+
+namespace duckdb {
+
+//! Opens a Parquet reader, reusing the parsed footer from the per-database chsql metadata cache.
+//! Cached footers are keyed by path and dropped when the file's modification time or size change.
+//! With enable_chsql_metadata_cache disabled this is a plain ParquetReader construction.
+unique_ptr<ParquetReader> OpenCachedParquetReader(ClientContext &context, const string &path,
+                                                  const ParquetOptions &options);
+
+//! Registers the enable_chsql_metadata_cache setting and the chsql_metadata_cache_stats() function
+void RegisterParquetMetadataCache(DatabaseInstance &instance);
+
+} // namespace duckdb
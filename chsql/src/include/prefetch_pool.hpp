@@ -0,0 +1,56 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/storage/object_cache.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+namespace duckdb {
+
+//! Prefetch settings of read_parquet_mergetree, read once per scan thread
+struct PrefetchSettings {
+	//! Chunks decoded ahead per merge input, 0 decodes on demand
+	idx_t depth = 0;
+	//! Bytes a scan thread may hold in chunks decoded ahead, shared by the inputs it merges
+	idx_t memory = 0;
+	idx_t threads = 1;
+
+	static PrefetchSettings Get(ClientContext &context);
+};
+
+//! Threads decoding chunks ahead of the merge of read_parquet_mergetree, shared by all scans of a database.
+//! Jobs never wait on scan threads, so the merge can always wait for a job without deadlocking, even when
+//! every thread of DuckDB's scheduler is merging. Jobs must not own the pool: the last reference released on
+//! a pool thread would join that thread from itself.
+class PrefetchPool : public ObjectCacheEntry {
+public:
+	~PrefetchPool() override;
+
+	static string ObjectType() {
+		return "chsql_prefetch_pool";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+	//! The pool of the database, grown to the configured number of threads
+	static shared_ptr<PrefetchPool> Get(ClientContext &context, const PrefetchSettings &settings);
+
+	void Submit(std::function<void()> job);
+
+private:
+	void EnsureThreads(idx_t count);
+	void Work();
+
+	mutex lock;
+	std::condition_variable wakeup;
+	std::deque<std::function<void()>> jobs;
+	vector<std::thread> threads;
+	bool shutdown = false;
+};
+
+//! Registers the chsql_prefetch_depth, chsql_prefetch_memory and chsql_prefetch_threads settings
+void RegisterPrefetchSettings(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/storage/object_cache.hpp"
+#include <chrono>
+
+namespace duckdb {
+
+//! Counters and phase timers of read_parquet_mergetree, reported by chsql_stats()
+enum class ScanCounter : uint8_t {
+	//! Files whose footers were read in bind, and the nanoseconds bind took
+	FILES_BOUND,
+	BIND_NANOS,
+	//! Readers constructed for the merge and the nanoseconds spent setting up key ranges
+	READERS_OPENED,
+	INIT_NANOS,
+	//! Row groups read by the merge and row groups skipped because statistics rule out a filter
+	ROW_GROUPS_SCANNED,
+	ROW_GROUPS_PRUNED,
+	//! Chunks decoded by the readers and the nanoseconds the merge spent decoding or waiting for them
+	CHUNKS_DECODED,
+	DECODE_NANOS,
+	//! Chunks the merge had to wait for because the prefetch had not decoded them yet
+	PREFETCH_STALLS,
+	//! Rows passing the merge, runs emitted without copying (fast path) or copied row by row
+	ROWS_MERGED,
+	ZERO_COPY_RUNS,
+	COPIED_RUNS,
+	//! Sort key comparisons of the merge heap and the run search
+	COMPARISONS,
+	//! Nanoseconds of the merge itself, decoding and range setup excluded
+	MERGE_NANOS,
+	COUNT
+};
+
+//! Counters of one scan thread or one bind. Every thread counts into its own instance without
+//! synchronization, the instance is added to the database totals when the thread is done.
+struct ScanStats {
+	idx_t values[static_cast<idx_t>(ScanCounter::COUNT)] = {};
+
+	static uint64_t Now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		           std::chrono::steady_clock::now().time_since_epoch())
+		    .count();
+	}
+	void Add(ScanCounter counter, idx_t amount = 1) {
+		values[static_cast<idx_t>(counter)] += amount;
+	}
+	//! Adds the nanoseconds elapsed since start, a value returned by Now()
+	void AddElapsed(ScanCounter counter, uint64_t start) {
+		Add(counter, Now() - start);
+	}
+	idx_t Get(ScanCounter counter) const {
+		return values[static_cast<idx_t>(counter)];
+	}
+};
+
+//! Totals of the scan counters of all queries of a database
+class ScanStatsTotals : public ObjectCacheEntry {
+public:
+	static string ObjectType() {
+		return "chsql_scan_stats";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+	static shared_ptr<ScanStatsTotals> Get(ClientContext &context);
+
+	void Add(const ScanStats &stats);
+	ScanStats Snapshot();
+
+private:
+	mutex lock;
+	ScanStats totals;
+};
+
+//! Registers chsql_stats(), one row per counter
+void RegisterScanStats(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/planner/table_filter.hpp"
+
+namespace duckdb {
+
+//! Evaluates a pushed-down TableFilter on a vector of a table function's output.
+//! Narrows sel (the first count entries) to the rows passing the filter and returns the number of remaining rows.
+idx_t SelectTableFilter(Vector &vector, idx_t vector_size, const TableFilter &filter, SelectionVector &sel,
+                        idx_t count);
+
+} // namespace duckdb
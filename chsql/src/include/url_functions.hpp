@@ -0,0 +1,10 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+//! Registers the native URL functions (protocol, domain, path, parseURL, extractURLParameter, ...)
+void RegisterURLFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -0,0 +1,388 @@
+#include "ip_functions.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/types/blob.hpp"
+#include "duckdb/common/vector_operations/generic_executor.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+// IPv4 addresses are UINTEGER, IPv6 addresses are 16 byte BLOBs in network byte order (ClickHouse's FixedString(16))
+static constexpr idx_t IPV6_BYTES = 16;
+static constexpr idx_t IPV4_MAX_STRING = 15;
+static constexpr idx_t IPV6_MAX_STRING = 45;
+
+//! Parses a dotted quad, rejecting anything but four decimal octets
+static bool TryParseIPv4(const char *data, idx_t size, uint32_t &result) {
+	uint32_t address = 0;
+	idx_t pos = 0;
+	for (idx_t octet = 0; octet < 4; octet++) {
+		if (octet > 0) {
+			if (pos >= size || data[pos] != '.') {
+				return false;
+			}
+			pos++;
+		}
+		idx_t digits = 0;
+		uint32_t value = 0;
+		while (pos < size && data[pos] >= '0' && data[pos] <= '9' && digits < 3) {
+			value = value * 10 + uint32_t(data[pos] - '0');
+			pos++;
+			digits++;
+		}
+		if (digits == 0 || value > 255) {
+			return false;
+		}
+		address = (address << 8) | value;
+	}
+	if (pos != size) {
+		return false;
+	}
+	result = address;
+	return true;
+}
+
+static inline int HexValue(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+//! Parses RFC 4291 text form including "::" compression and a trailing dotted quad. Plain IPv4 addresses are
+//! accepted as well and become IPv4-mapped addresses, like ClickHouse does.
+static bool TryParseIPv6(const char *data, idx_t size, uint8_t result[IPV6_BYTES]) {
+	uint32_t ipv4;
+	if (TryParseIPv4(data, size, ipv4)) {
+		memset(result, 0, 10);
+		result[10] = result[11] = 0xff;
+		for (idx_t i = 0; i < 4; i++) {
+			result[12 + i] = uint8_t(ipv4 >> (24 - 8 * i));
+		}
+		return true;
+	}
+	uint8_t bytes[IPV6_BYTES];
+	idx_t written = 0;
+	idx_t gap = DConstants::INVALID_INDEX;
+	idx_t pos = 0;
+	if (size >= 2 && data[0] == ':' && data[1] == ':') {
+		gap = 0;
+		pos = 2;
+	}
+	while (pos < size) {
+		if (written == IPV6_BYTES) {
+			return false;
+		}
+		// a trailing dotted quad fills the last 32 bits
+		auto group_end = pos;
+		while (group_end < size && data[group_end] != ':') {
+			group_end++;
+		}
+		if (group_end == size && memchr(data + pos, '.', size - pos)) {
+			if (written + 4 > IPV6_BYTES || !TryParseIPv4(data + pos, size - pos, ipv4)) {
+				return false;
+			}
+			for (idx_t i = 0; i < 4; i++) {
+				bytes[written++] = uint8_t(ipv4 >> (24 - 8 * i));
+			}
+			pos = size;
+			break;
+		}
+		if (group_end == pos || group_end - pos > 4) {
+			return false;
+		}
+		uint32_t value = 0;
+		for (auto i = pos; i < group_end; i++) {
+			auto digit = HexValue(data[i]);
+			if (digit < 0) {
+				return false;
+			}
+			value = (value << 4) | uint32_t(digit);
+		}
+		bytes[written++] = uint8_t(value >> 8);
+		bytes[written++] = uint8_t(value);
+		pos = group_end;
+		if (pos < size) {
+			// skip ':' and note a "::" gap
+			pos++;
+			if (pos < size && data[pos] == ':') {
+				if (gap != DConstants::INVALID_INDEX) {
+					return false;
+				}
+				gap = written;
+				pos++;
+			} else if (pos == size) {
+				return false;
+			}
+		}
+	}
+	if (gap == DConstants::INVALID_INDEX) {
+		if (written != IPV6_BYTES) {
+			return false;
+		}
+		memcpy(result, bytes, IPV6_BYTES);
+		return true;
+	}
+	if (written == IPV6_BYTES) {
+		return false;
+	}
+	const auto tail = written - gap;
+	memcpy(result, bytes, gap);
+	memset(result + gap, 0, IPV6_BYTES - written);
+	memcpy(result + IPV6_BYTES - tail, bytes + gap, tail);
+	return true;
+}
+
+static idx_t FormatIPv4(uint32_t address, char *buffer) {
+	idx_t pos = 0;
+	for (idx_t i = 0; i < 4; i++) {
+		if (i > 0) {
+			buffer[pos++] = '.';
+		}
+		const auto octet = uint8_t(address >> (24 - 8 * i));
+		if (octet >= 100) {
+			buffer[pos++] = char('0' + octet / 100);
+		}
+		if (octet >= 10) {
+			buffer[pos++] = char('0' + octet / 10 % 10);
+		}
+		buffer[pos++] = char('0' + octet % 10);
+	}
+	return pos;
+}
+
+//! RFC 5952 text form: lowercase hex, the longest run of two or more zero groups collapsed to "::",
+//! IPv4-mapped addresses printed as ::ffff:a.b.c.d
+static idx_t FormatIPv6(const uint8_t bytes[IPV6_BYTES], char *buffer) {
+	static constexpr const char *HEX = "0123456789abcdef";
+	uint16_t groups[8];
+	for (idx_t i = 0; i < 8; i++) {
+		groups[i] = uint16_t(bytes[2 * i] << 8 | bytes[2 * i + 1]);
+	}
+	idx_t best_begin = 8, best_length = 0;
+	for (idx_t i = 0; i < 8;) {
+		if (groups[i] != 0) {
+			i++;
+			continue;
+		}
+		auto run_end = i;
+		while (run_end < 8 && groups[run_end] == 0) {
+			run_end++;
+		}
+		if (run_end - i > best_length) {
+			best_begin = i;
+			best_length = run_end - i;
+		}
+		i = run_end;
+	}
+	if (best_length < 2) {
+		best_begin = 8;
+		best_length = 0;
+	}
+	const bool ipv4_mapped = best_begin == 0 && best_length == 5 && groups[5] == 0xffff;
+	idx_t pos = 0;
+	for (idx_t i = 0; i < 8; i++) {
+		if (i == best_begin) {
+			buffer[pos++] = ':';
+			buffer[pos++] = ':';
+			i += best_length - 1;
+			continue;
+		}
+		if (ipv4_mapped && i == 6) {
+			buffer[pos++] = ':';
+			pos += FormatIPv4(uint32_t(groups[6]) << 16 | groups[7], buffer + pos);
+			break;
+		}
+		if (i > 0 && buffer[pos - 1] != ':') {
+			buffer[pos++] = ':';
+		}
+		bool leading = true;
+		for (int shift = 12; shift >= 0; shift -= 4) {
+			const auto digit = (groups[i] >> shift) & 0xf;
+			if (leading && digit == 0 && shift > 0) {
+				continue;
+			}
+			leading = false;
+			buffer[pos++] = HEX[digit];
+		}
+	}
+	return pos;
+}
+
+//! Signed inputs use their low 32 bits, so INTEGER/BIGINT columns holding addresses format as before
+template <class T>
+static void IPv4NumToStringFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	UnaryExecutor::Execute<T, string_t>(args.data[0], result, args.size(), [&](T address) {
+		char buffer[IPV4_MAX_STRING];
+		return StringVector::AddString(result, buffer, FormatIPv4(uint32_t(address), buffer));
+	});
+}
+
+//! Invalid addresses become 0, as in ClickHouse
+static void IPv4StringToNumFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	UnaryExecutor::Execute<string_t, uint32_t>(args.data[0], result, args.size(), [&](string_t input) {
+		uint32_t address;
+		return TryParseIPv4(input.GetData(), input.GetSize(), address) ? address : 0;
+	});
+}
+
+static void ToIPv4Function(DataChunk &args, ExpressionState &state, Vector &result) {
+	UnaryExecutor::Execute<string_t, uint32_t>(args.data[0], result, args.size(), [&](string_t input) {
+		uint32_t address;
+		if (!TryParseIPv4(input.GetData(), input.GetSize(), address)) {
+			throw InvalidInputException("toIPv4: invalid IPv4 address \"%s\"", input.GetString());
+		}
+		return address;
+	});
+}
+
+static void IPv6NumToStringFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	UnaryExecutor::Execute<string_t, string_t>(args.data[0], result, args.size(), [&](string_t input) {
+		if (input.GetSize() != IPV6_BYTES) {
+			throw InvalidInputException("IPv6NumToString: expected a %llu byte address, got %llu bytes", IPV6_BYTES,
+										input.GetSize());
+		}
+		char buffer[IPV6_MAX_STRING];
+		const auto size = FormatIPv6(const_data_ptr_cast(input.GetData()), buffer);
+		return StringVector::AddString(result, buffer, size);
+	});
+}
+
+//! Invalid addresses become 16 zero bytes, as in ClickHouse
+static void IPv6StringToNumFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	UnaryExecutor::Execute<string_t, string_t>(args.data[0], result, args.size(), [&](string_t input) {
+		auto address = StringVector::EmptyString(result, IPV6_BYTES);
+		auto bytes = data_ptr_cast(address.GetDataWriteable());
+		if (!TryParseIPv6(input.GetData(), input.GetSize(), bytes)) {
+			memset(bytes, 0, IPV6_BYTES);
+		}
+		address.Finalize();
+		return address;
+	});
+}
+
+static uint32_t IPv4Mask(uint8_t prefix) {
+	return prefix == 0 ? 0 : ~uint32_t(0) << (32 - MinValue<uint8_t>(prefix, 32));
+}
+
+static void IPv4CIDRToRangeFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &entries = StructVector::GetEntries(result);
+	auto &lower = *entries[0];
+	auto &upper = *entries[1];
+	const auto count = args.size();
+	UnifiedVectorFormat address_format, prefix_format;
+	args.data[0].ToUnifiedFormat(count, address_format);
+	args.data[1].ToUnifiedFormat(count, prefix_format);
+	const auto addresses = UnifiedVectorFormat::GetData<uint32_t>(address_format);
+	const auto prefixes = UnifiedVectorFormat::GetData<uint8_t>(prefix_format);
+	auto lower_data = FlatVector::GetData<uint32_t>(lower);
+	auto upper_data = FlatVector::GetData<uint32_t>(upper);
+	auto &result_mask = FlatVector::Validity(result);
+	for (idx_t i = 0; i < count; i++) {
+		const auto address_idx = address_format.sel->get_index(i);
+		const auto prefix_idx = prefix_format.sel->get_index(i);
+		if (!address_format.validity.RowIsValid(address_idx) || !prefix_format.validity.RowIsValid(prefix_idx)) {
+			result_mask.SetInvalid(i);
+			continue;
+		}
+		const auto mask = IPv4Mask(prefixes[prefix_idx]);
+		lower_data[i] = addresses[address_idx] & mask;
+		upper_data[i] = addresses[address_idx] | ~mask;
+	}
+	if (args.AllConstant()) {
+		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+	}
+}
+
+//! An address or CIDR block in IPv6 form, IPv4 ones are mapped into ::ffff:0:0/96
+struct IPNetwork {
+	uint8_t bytes[IPV6_BYTES];
+	idx_t prefix;
+};
+
+static IPNetwork ParseIPNetwork(string_t input, bool with_prefix) {
+	IPNetwork result;
+	const auto data = input.GetData();
+	auto size = input.GetSize();
+	result.prefix = IPV6_BYTES * 8;
+	if (with_prefix) {
+		auto slash = static_cast<const char *>(memchr(data, '/', size));
+		if (!slash) {
+			throw InvalidInputException("isIPAddressInRange: invalid CIDR \"%s\"", input.GetString());
+		}
+		idx_t prefix = 0;
+		for (auto c = slash + 1; c < data + size; c++) {
+			if (*c < '0' || *c > '9' || prefix > 128) {
+				throw InvalidInputException("isIPAddressInRange: invalid CIDR \"%s\"", input.GetString());
+			}
+			prefix = prefix * 10 + idx_t(*c - '0');
+		}
+		size = slash - data;
+		result.prefix = prefix;
+	}
+	uint32_t ipv4;
+	const bool is_ipv4 = TryParseIPv4(data, size, ipv4);
+	if (!TryParseIPv6(data, size, result.bytes)) {
+		throw InvalidInputException("isIPAddressInRange: invalid IP address \"%s\"", input.GetString());
+	}
+	if (with_prefix && is_ipv4) {
+		if (result.prefix > 32) {
+			throw InvalidInputException("isIPAddressInRange: invalid CIDR \"%s\"", input.GetString());
+		}
+		result.prefix += 96;
+	} else if (result.prefix > 128) {
+		throw InvalidInputException("isIPAddressInRange: invalid CIDR \"%s\"", input.GetString());
+	}
+	return result;
+}
+
+static void IsIPAddressInRangeFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	BinaryExecutor::Execute<string_t, string_t, bool>(
+	    args.data[0], args.data[1], result, args.size(), [&](string_t address_string, string_t cidr_string) {
+		    const auto address = ParseIPNetwork(address_string, false);
+		    const auto network = ParseIPNetwork(cidr_string, true);
+		    const auto full_bytes = network.prefix / 8;
+		    if (memcmp(address.bytes, network.bytes, full_bytes) != 0) {
+			    return false;
+		    }
+		    const auto rest = network.prefix % 8;
+		    if (rest == 0) {
+			    return true;
+		    }
+		    const auto mask = uint8_t(0xff << (8 - rest));
+		    return (address.bytes[full_bytes] & mask) == (network.bytes[full_bytes] & mask);
+	    });
+}
+
+void RegisterIPFunctions(DatabaseInstance &instance) {
+	ScalarFunctionSet ipv4_num_to_string("IPv4NumToString");
+	ipv4_num_to_string.AddFunction(
+	    ScalarFunction({LogicalType::UINTEGER}, LogicalType::VARCHAR, IPv4NumToStringFunction<uint32_t>));
+	ipv4_num_to_string.AddFunction(
+	    ScalarFunction({LogicalType::BIGINT}, LogicalType::VARCHAR, IPv4NumToStringFunction<int64_t>));
+	ExtensionUtil::RegisterFunction(instance, ipv4_num_to_string);
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv4StringToNum", {LogicalType::VARCHAR},
+															 LogicalType::UINTEGER, IPv4StringToNumFunction));
+	ExtensionUtil::RegisterFunction(
+	    instance, ScalarFunction("toIPv4", {LogicalType::VARCHAR}, LogicalType::UINTEGER, ToIPv4Function));
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv6NumToString", {LogicalType::BLOB},
+															 LogicalType::VARCHAR, IPv6NumToStringFunction));
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv6StringToNum", {LogicalType::VARCHAR},
+															 LogicalType::BLOB, IPv6StringToNumFunction));
+	child_list_t<LogicalType> range_children {{"lower", LogicalType::UINTEGER}, {"upper", LogicalType::UINTEGER}};
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv4CIDRToRange",
+															 {LogicalType::UINTEGER, LogicalType::UTINYINT},
+															 LogicalType::STRUCT(range_children), IPv4CIDRToRangeFunction));
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("isIPAddressInRange",
+															 {LogicalType::VARCHAR, LogicalType::VARCHAR},
+															 LogicalType::BOOLEAN, IsIPAddressInRangeFunction));
+}
+
+} // namespace duckdb
@@ -0,0 +1,128 @@
+#include "numbers_function.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+
+namespace duckdb {
+
+struct NumbersBindData : TableFunctionData {
+	int64_t offset = 0;
+	idx_t count = 0;
+	bool parallel = false;
+};
+
+//! Rows a thread claims at a time: large enough to keep the claims off the profile, small enough to balance the
+//! threads of numbers_mt
+static constexpr idx_t NUMBERS_MORSEL_ROWS = 64 * STANDARD_VECTOR_SIZE;
+
+struct NumbersGlobalState : GlobalTableFunctionState {
+	atomic<idx_t> next_morsel {0};
+	idx_t morsels = 0;
+	idx_t max_threads = 1;
+
+	idx_t MaxThreads() const override {
+		return max_threads;
+	}
+};
+
+struct NumbersLocalState : LocalTableFunctionState {
+	idx_t morsel = DConstants::INVALID_INDEX;
+	idx_t position = 0;
+	idx_t end = 0;
+};
+
+static int64_t NumbersArgument(const Value &value, const char *name) {
+	if (value.IsNull()) {
+		throw BinderException("numbers: %s must not be NULL", name);
+	}
+	return value.GetValue<int64_t>();
+}
+
+//! numbers(N) produces 0 .. N-1, numbers(offset, N) produces offset .. offset+N-1, as in ClickHouse
+static unique_ptr<FunctionData> NumbersBind(ClientContext &context, TableFunctionBindInput &input,
+                                            vector<LogicalType> &return_types, vector<string> &names) {
+	auto res = make_uniq<NumbersBindData>();
+	int64_t count;
+	if (input.inputs.size() == 1) {
+		count = NumbersArgument(input.inputs[0], "N");
+	} else {
+		res->offset = NumbersArgument(input.inputs[0], "offset");
+		count = NumbersArgument(input.inputs[1], "N");
+	}
+	if (count < 0) {
+		throw BinderException("numbers: N must not be negative");
+	}
+	if (count > 0 && res->offset > NumericLimits<int64_t>::Maximum() - (count - 1)) {
+		throw BinderException("numbers: offset + N exceeds the BIGINT range");
+	}
+	res->count = idx_t(count);
+	res->parallel = input.table_function.name == "numbers_mt";
+	names = {"number"};
+	return_types = {LogicalType::BIGINT};
+	return std::move(res);
+}
+
+static unique_ptr<GlobalTableFunctionState> NumbersInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+	auto &data = input.bind_data->Cast<NumbersBindData>();
+	auto res = make_uniq<NumbersGlobalState>();
+	res->morsels = (data.count + NUMBERS_MORSEL_ROWS - 1) / NUMBERS_MORSEL_ROWS;
+	if (data.parallel) {
+		const auto threads = idx_t(TaskScheduler::GetScheduler(context).NumberOfThreads());
+		res->max_threads = MaxValue<idx_t>(MinValue(threads, res->morsels), 1);
+	}
+	return std::move(res);
+}
+
+static unique_ptr<LocalTableFunctionState> NumbersInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                            GlobalTableFunctionState *global_state) {
+	return make_uniq<NumbersLocalState>();
+}
+
+//! Every chunk is a sequence vector: the numbers are only written out by the operator that flattens it
+static void NumbersFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &data = data_p.bind_data->Cast<NumbersBindData>();
+	auto &state = data_p.global_state->Cast<NumbersGlobalState>();
+	auto &local = data_p.local_state->Cast<NumbersLocalState>();
+	if (local.position == local.end) {
+		local.morsel = state.next_morsel++;
+		if (local.morsel >= state.morsels) {
+			return;
+		}
+		local.position = local.morsel * NUMBERS_MORSEL_ROWS;
+		local.end = MinValue(local.position + NUMBERS_MORSEL_ROWS, data.count);
+	}
+	const auto count = MinValue<idx_t>(local.end - local.position, STANDARD_VECTOR_SIZE);
+	output.data[0].Sequence(data.offset + int64_t(local.position), 1, count);
+	output.SetCardinality(count);
+	local.position += count;
+}
+
+//! Morsels are claimed in order, so the morsel index keeps numbers_mt ordered when DuckDB preserves insertion order
+static idx_t NumbersGetBatchIndex(ClientContext &context, const FunctionData *bind_data_p,
+                                  LocalTableFunctionState *local_state, GlobalTableFunctionState *global_state) {
+	return local_state->Cast<NumbersLocalState>().morsel;
+}
+
+static unique_ptr<NodeStatistics> NumbersCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &data = bind_data_p->Cast<NumbersBindData>();
+	return make_uniq<NodeStatistics>(data.count, data.count);
+}
+
+static TableFunctionSet NumbersFunctionSet(const string &name) {
+	TableFunctionSet set(name);
+	for (idx_t arguments = 1; arguments <= 2; arguments++) {
+		TableFunction numbers(name, vector<LogicalType>(arguments, LogicalType::BIGINT), NumbersFunction, NumbersBind,
+		                      NumbersInitGlobal, NumbersInitLocal);
+		numbers.get_batch_index = NumbersGetBatchIndex;
+		numbers.cardinality = NumbersCardinality;
+		set.AddFunction(numbers);
+	}
+	return set;
+}
+
+void RegisterNumbersFunctions(DatabaseInstance &instance) {
+	ExtensionUtil::RegisterFunction(instance, NumbersFunctionSet("numbers"));
+	ExtensionUtil::RegisterFunction(instance, NumbersFunctionSet("numbers_mt"));
+}
+
+} // namespace duckdb
@@ -0,0 +1,145 @@
+#include "parquet_metadata_cache.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+namespace duckdb {
+
+static constexpr const char *METADATA_CACHE_SETTING = "enable_chsql_metadata_cache";
+
+struct CachedFooter {
+	time_t last_modified;
+	idx_t file_size;
+	//! Size of the Thrift encoded footer
+	idx_t footer_bytes;
+	shared_ptr<ParquetFileMetadataCache> metadata;
+};
+
+class ChsqlMetadataCache : public ObjectCacheEntry {
+public:
+	static string ObjectType() {
+		return "chsql_metadata_cache";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	static ChsqlMetadataCache &Get(ClientContext &context) {
+		return *ObjectCache::GetObjectCache(context).GetOrCreate<ChsqlMetadataCache>(ObjectType());
+	}
+
+	shared_ptr<ParquetFileMetadataCache> Lookup(const string &path, time_t last_modified, idx_t file_size) {
+		lock_guard<mutex> guard(lock);
+		auto entry = footers.find(path);
+		if (entry == footers.end() || entry->second.last_modified != last_modified ||
+		    entry->second.file_size != file_size) {
+			misses++;
+			return nullptr;
+		}
+		hits++;
+		return entry->second.metadata;
+	}
+
+	void Store(const string &path, CachedFooter footer) {
+		lock_guard<mutex> guard(lock);
+		auto entry = footers.find(path);
+		if (entry != footers.end()) {
+			bytes -= entry->second.footer_bytes;
+		}
+		bytes += footer.footer_bytes;
+		footers[path] = std::move(footer);
+	}
+
+	mutex lock;
+	unordered_map<string, CachedFooter> footers;
+	idx_t hits = 0;
+	idx_t misses = 0;
+	idx_t bytes = 0;
+};
+
+static bool MetadataCacheEnabled(ClientContext &context) {
+	Value enabled;
+	if (!context.TryGetCurrentSetting(METADATA_CACHE_SETTING, enabled)) {
+		return true;
+	}
+	return enabled.GetValue<bool>();
+}
+
+//! Reads the footer length stored in front of the trailing "PAR1" magic
+static idx_t ReadFooterLength(FileHandle &handle, idx_t file_size) {
+	if (file_size < 8) {
+		return 0;
+	}
+	data_t tail[8];
+	handle.Read(tail, sizeof(tail), file_size - sizeof(tail));
+	return Load<uint32_t>(tail);
+}
+
+unique_ptr<ParquetReader> OpenCachedParquetReader(ClientContext &context, const string &path,
+                                                  const ParquetOptions &options) {
+	if (!MetadataCacheEnabled(context)) {
+		return make_uniq<ParquetReader>(context, path, options, nullptr);
+	}
+	auto &fs = FileSystem::GetFileSystem(context);
+	auto handle = fs.OpenFile(path, FileFlags::FILE_FLAGS_READ);
+	const auto last_modified = fs.GetLastModifiedTime(*handle);
+	const auto file_size = NumericCast<idx_t>(fs.GetFileSize(*handle));
+
+	auto &cache = ChsqlMetadataCache::Get(context);
+	auto metadata = cache.Lookup(path, last_modified, file_size);
+	if (metadata) {
+		return make_uniq<ParquetReader>(context, path, options, std::move(metadata));
+	}
+	auto reader = make_uniq<ParquetReader>(context, path, options, nullptr);
+	CachedFooter footer;
+	footer.last_modified = last_modified;
+	footer.file_size = file_size;
+	footer.footer_bytes = ReadFooterLength(*handle, file_size);
+	footer.metadata = reader->metadata;
+	cache.Store(path, std::move(footer));
+	return reader;
+}
+
+struct MetadataCacheStatsState : GlobalTableFunctionState {
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> MetadataCacheStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"entries", "hits", "misses", "bytes"};
+	return_types = {LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT};
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> MetadataCacheStatsInit(ClientContext &context,
+                                                                   TableFunctionInitInput &input) {
+	return make_uniq<MetadataCacheStatsState>();
+}
+
+static void MetadataCacheStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<MetadataCacheStatsState>();
+	if (state.done) {
+		return;
+	}
+	state.done = true;
+	auto &cache = ChsqlMetadataCache::Get(context);
+	lock_guard<mutex> guard(cache.lock);
+	output.SetValue(0, 0, Value::UBIGINT(cache.footers.size()));
+	output.SetValue(1, 0, Value::UBIGINT(cache.hits));
+	output.SetValue(2, 0, Value::UBIGINT(cache.misses));
+	output.SetValue(3, 0, Value::UBIGINT(cache.bytes));
+	output.SetCardinality(1);
+}
+
+void RegisterParquetMetadataCache(DatabaseInstance &instance) {
+	auto &config = DBConfig::GetConfig(instance);
+	config.AddExtensionOption(METADATA_CACHE_SETTING,
+	                          "Reuse parsed Parquet footers across bind and scans of read_parquet_mergetree",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(true));
+	TableFunction stats("chsql_metadata_cache_stats", {}, MetadataCacheStatsFunction, MetadataCacheStatsBind,
+	                    MetadataCacheStatsInit);
+	ExtensionUtil::RegisterFunction(instance, stats);
+}
+
+} // namespace duckdb
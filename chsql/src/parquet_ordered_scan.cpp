@@ -1,26 +1,608 @@
 #include <duckdb.hpp>
+#include "duckdb/catalog/catalog_entry/copy_function_catalog_entry.hpp"
+#include "duckdb/common/error_data.hpp"
 #include "duckdb/common/exception.hpp"
+#include "duckdb/common/operator/add.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/common/radix.hpp"
+#include "duckdb/execution/execution_context.hpp"
+#include "duckdb/function/copy_function.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/parallel/thread_context.hpp"
+#include "duckdb/parser/expression/columnref_expression.hpp"
+#include "duckdb/parser/parsed_data/copy_info.hpp"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+#include "duckdb/planner/filter/null_filter.hpp"
+#include "duckdb/planner/filter/optional_filter.hpp"
+#include "duckdb/planner/table_filter.hpp"
+#include "duckdb/storage/statistics/base_statistics.hpp"
 #include <parquet_reader.hpp>
+#include <parquet_statistics.hpp>
+#include <thrift_tools.hpp>
 #include "chsql_extension.hpp"
+#include "parquet_metadata_cache.hpp"
+#include "prefetch_pool.hpp"
+#include "scan_stats.hpp"
+#include "table_filter_select.hpp"
 #include <duckdb/common/multi_file_list.hpp>
 
 namespace duckdb {
 
+	//! Footer statistics of the order-by column for one row group
+	struct RowGroupKeyRange {
+		Value min;
+		Value max;
+		bool has_stats = false;
+		bool may_have_nulls = true;
+		idx_t rows = 0;
+	};
+
+	//! Chunks of one merge input decoded ahead on the prefetch pool. While a decode is in flight the pool uses
+	//! the reader and its scan state, the merge only takes chunks out of the ready queue. Chunks return to the
+	//! spare list when the merge asks for the next one, after the output referencing them was consumed. The pool
+	//! is owned by the scan's local state, which cancels every prefetch before it lets go of the pool: a queued
+	//! job may drop the last reference to the prefetch on a pool thread, which must not destroy the pool.
+	struct ChunkPrefetch : enable_shared_from_this<ChunkPrefetch> {
+		ChunkPrefetch(ParquetReader &reader_p, ParquetReaderScanState &scanState_p, Allocator &allocator_p,
+					  vector<LogicalType> types_p, idx_t depth_p, PrefetchPool &pool_p)
+			: reader(reader_p), scanState(scanState_p), allocator(allocator_p), types(std::move(types_p)),
+			  depth(depth_p), pool(pool_p) {
+		}
+
+		ParquetReader &reader;
+		ParquetReaderScanState &scanState;
+		Allocator &allocator;
+		vector<LogicalType> types;
+		//! Decoded chunks kept ready at most
+		idx_t depth;
+		PrefetchPool &pool;
+
+		mutex lock;
+		std::condition_variable decoded;
+		std::deque<unique_ptr<DataChunk>> ready;
+		vector<unique_ptr<DataChunk>> spare;
+		bool inFlight = false;
+		bool exhausted = false;
+		bool cancelled = false;
+		ErrorData error;
+
+		//! Queues the next decode unless one is running or enough chunks are ready, called with the lock held
+		void Schedule() {
+			if (inFlight || exhausted || cancelled || error.HasError() || ready.size() >= depth) {
+				return;
+			}
+			inFlight = true;
+			auto self = shared_from_this();
+			pool.Submit([self]() { self->Decode(); });
+		}
+		void Decode() {
+			unique_ptr<DataChunk> target;
+			{
+				lock_guard<mutex> guard(lock);
+				if (cancelled) {
+					inFlight = false;
+					decoded.notify_all();
+					return;
+				}
+				if (spare.empty()) {
+					target = make_uniq<DataChunk>();
+					target->Initialize(allocator, types);
+				} else {
+					target = std::move(spare.back());
+					spare.pop_back();
+				}
+			}
+			ErrorData scan_error;
+			try {
+				target->Reset();
+				reader.Scan(scanState, *target);
+			} catch (std::exception &ex) {
+				scan_error = ErrorData(ex);
+			}
+			lock_guard<mutex> guard(lock);
+			inFlight = false;
+			if (scan_error.HasError()) {
+				error = std::move(scan_error);
+			} else if (target->size() == 0) {
+				exhausted = true;
+				spare.push_back(std::move(target));
+			} else {
+				ready.push_back(std::move(target));
+			}
+			Schedule();
+			decoded.notify_all();
+		}
+		//! Swaps the consumed chunk for the next decoded one, an empty chunk once the file is exhausted.
+		//! Returns whether the merge had to wait for the decode.
+		bool Next(unique_ptr<DataChunk> &chunk) {
+			std::unique_lock<mutex> guard(lock);
+			spare.push_back(std::move(chunk));
+			Schedule();
+			const bool stalled = ready.empty() && inFlight;
+			decoded.wait(guard, [this]() { return !ready.empty() || !inFlight; });
+			if (error.HasError()) {
+				error.Throw();
+			}
+			if (ready.empty()) {
+				chunk = std::move(spare.back());
+				spare.pop_back();
+				chunk->Reset();
+				return stalled;
+			}
+			chunk = std::move(ready.front());
+			ready.pop_front();
+			Schedule();
+			return stalled;
+		}
+		//! Stops decoding ahead and waits for a running decode, the reader can be dropped afterwards
+		void Cancel() {
+			std::unique_lock<mutex> guard(lock);
+			cancelled = true;
+			decoded.wait(guard, [this]() { return !inFlight; });
+		}
+	};
+
 	struct ReaderSet {
 		unique_ptr<ParquetReader> reader;
-		idx_t orderByIdx;
+		//! Index of the file in the bind data
+		idx_t fileIdx = 0;
+		idx_t orderByIdx = DConstants::INVALID_INDEX;
+		//! File column index of the order-by column
+		idx_t orderByColumn = DConstants::INVALID_INDEX;
 		unique_ptr<DataChunk> chunk;
 		unique_ptr<ParquetReaderScanState> scanState;
 		vector<idx_t> columnMap;
+		//! Output columns this file does not have, emitted as NULL
+		vector<idx_t> missingColumns;
+		vector<RowGroupKeyRange> rowGroupKeys;
 		idx_t result_idx;
+		//! Rows [end_idx, chunk->size()) fall beyond the upper bound of the key range being merged
+		idx_t end_idx = 0;
+		bool past_range = false;
+		//! Unified view over the order-by column of the current chunk, refreshed on every scan
+		UnifiedVectorFormat orderByFormat;
+		//! Normalized sort keys of the current chunk, SortKeyLayout::width bytes per row
+		unsafe_unique_array<data_t> keys;
+		//! Unified views over all sort key columns, used to break ties between string prefixes
+		vector<UnifiedVectorFormat> keyFormats;
+		//! Chunks decoded ahead, null when the set decodes on demand
+		shared_ptr<ChunkPrefetch> prefetch;
+
+		~ReaderSet() {
+			StopPrefetch();
+		}
+		void StartPrefetch(Allocator &allocator, idx_t depth, PrefetchPool &pool) {
+			prefetch = make_shared_ptr<ChunkPrefetch>(*reader, *scanState, allocator, chunk->GetTypes(), depth, pool);
+			lock_guard<mutex> guard(prefetch->lock);
+			prefetch->Schedule();
+		}
+		void StopPrefetch() {
+			if (prefetch) {
+				prefetch->Cancel();
+				prefetch.reset();
+			}
+		}
+		//! Decodes the next chunk of this file, returns false once the file is exhausted
+		bool ScanNext(ScanStats &stats) {
+			if (prefetch) {
+				if (prefetch->Next(chunk)) {
+					stats.Add(ScanCounter::PREFETCH_STALLS);
+				}
+			} else {
+				chunk->Reset();
+				reader->Scan(*scanState, *chunk);
+			}
+			for (const auto col : missingColumns) {
+				chunk->data[col].SetVectorType(VectorType::CONSTANT_VECTOR);
+				ConstantVector::SetNull(chunk->data[col], true);
+			}
+			result_idx = 0;
+			end_idx = chunk->size();
+			chunk->data[orderByIdx].ToUnifiedFormat(chunk->size(), orderByFormat);
+			return chunk->size() > 0;
+		}
+		bool Exhausted() const {
+			return result_idx >= end_idx;
+		}
+	};
+
+	//! Three-way comparison of two order-by keys, NULLs sort last (DuckDB's default ASC NULLS LAST)
+	typedef int (*order_key_compare_t)(const UnifiedVectorFormat &l, idx_t l_row,
+									   const UnifiedVectorFormat &r, idx_t r_row);
+
+	template <class T>
+	static int CompareOrderKeys(const UnifiedVectorFormat &l, idx_t l_row,
+								const UnifiedVectorFormat &r, idx_t r_row) {
+		const auto l_idx = l.sel->get_index(l_row);
+		const auto r_idx = r.sel->get_index(r_row);
+		const auto l_valid = l.validity.RowIsValid(l_idx);
+		const auto r_valid = r.validity.RowIsValid(r_idx);
+		if (!l_valid || !r_valid) {
+			return l_valid ? -1 : (r_valid ? 1 : 0);
+		}
+		const auto &l_val = UnifiedVectorFormat::GetData<T>(l)[l_idx];
+		const auto &r_val = UnifiedVectorFormat::GetData<T>(r)[r_idx];
+		if (LessThan::Operation<T>(l_val, r_val)) {
+			return -1;
+		}
+		if (LessThan::Operation<T>(r_val, l_val)) {
+			return 1;
+		}
+		return 0;
+	}
+
+	static order_key_compare_t GetOrderKeyComparator(const LogicalType &type) {
+		switch (type.InternalType()) {
+		case PhysicalType::BOOL:
+		case PhysicalType::INT8:
+			return CompareOrderKeys<int8_t>;
+		case PhysicalType::INT16:
+			return CompareOrderKeys<int16_t>;
+		case PhysicalType::INT32:
+			return CompareOrderKeys<int32_t>;
+		case PhysicalType::INT64:
+			return CompareOrderKeys<int64_t>;
+		case PhysicalType::UINT8:
+			return CompareOrderKeys<uint8_t>;
+		case PhysicalType::UINT16:
+			return CompareOrderKeys<uint16_t>;
+		case PhysicalType::UINT32:
+			return CompareOrderKeys<uint32_t>;
+		case PhysicalType::UINT64:
+			return CompareOrderKeys<uint64_t>;
+		case PhysicalType::INT128:
+			return CompareOrderKeys<hugeint_t>;
+		case PhysicalType::FLOAT:
+			return CompareOrderKeys<float>;
+		case PhysicalType::DOUBLE:
+			return CompareOrderKeys<double>;
+		case PhysicalType::VARCHAR:
+			return CompareOrderKeys<string_t>;
+		default:
+			throw NotImplementedException("read_parquet_mergetree: unsupported order by type %s", type.ToString());
+		}
+	}
+
+	//! One column of the sort key, e.g. "ts DESC NULLS FIRST"
+	struct SortKeyColumn {
+		string name;
+		bool descending = false;
+		bool nulls_first = false;
+		//! Global column index, resolved in bind
+		idx_t globalIdx = DConstants::INVALID_INDEX;
+	};
+
+	//! Parses a comma separated ORDER BY list of plain column references
+	static vector<SortKeyColumn> ParseSortKey(const string &orderBy) {
+		vector<SortKeyColumn> result;
+		for (auto &node : Parser::ParseOrderList(orderBy)) {
+			if (node.expression->GetExpressionClass() != ExpressionClass::COLUMN_REF) {
+				throw BinderException("read_parquet_mergetree: sort key \"%s\" must be a column name",
+									  node.expression->ToString());
+			}
+			SortKeyColumn column;
+			column.name = node.expression->Cast<ColumnRefExpression>().GetColumnName();
+			column.descending = node.type == OrderType::DESCENDING;
+			column.nulls_first = node.null_order == OrderByNullType::NULLS_FIRST;
+			result.push_back(std::move(column));
+		}
+		if (result.empty()) {
+			throw BinderException("read_parquet_mergetree: empty sort key");
+		}
+		return result;
+	}
+
+	//! Normalized key encoding of a multi-column sort key, the approach of DuckDB's sort: every row becomes a
+	//! fixed-width byte string whose memcmp order is the sort order. Each column contributes a NULL byte placed
+	//! for the requested NULLS FIRST/LAST followed by its radix encoded value, inverted for DESC. Strings only
+	//! store a prefix, so keys holding strings are compared column by column and an equal prefix falls back to
+	//! a full comparison of the strings before the next column is looked at.
+	struct SortKeyLayout {
+		static constexpr idx_t STRING_PREFIX = 12;
+
+		struct Column {
+			idx_t chunkIdx;
+			PhysicalType type;
+			bool descending;
+			bool nulls_first;
+			idx_t offset;
+			idx_t width;
+			order_key_compare_t compare;
+		};
+		vector<Column> columns;
+		idx_t width = 0;
+		bool hasStringPrefixes = false;
+
+		void Initialize(const vector<SortKeyColumn> &key, const vector<idx_t> &chunkColumns,
+						const vector<LogicalType> &types) {
+			for (idx_t k = 0; k < key.size(); k++) {
+				Column column;
+				column.chunkIdx = chunkColumns[k];
+				column.type = types[k].InternalType();
+				column.descending = key[k].descending;
+				column.nulls_first = key[k].nulls_first;
+				column.offset = width;
+				column.compare = GetOrderKeyComparator(types[k]);
+				if (column.type == PhysicalType::VARCHAR) {
+					column.width = STRING_PREFIX;
+					hasStringPrefixes = true;
+				} else {
+					column.width = GetTypeIdSize(column.type);
+				}
+				width += 1 + column.width;
+				columns.push_back(column);
+			}
+		}
+
+		template <class T>
+		static void EncodeValues(const UnifiedVectorFormat &format, idx_t count, data_ptr_t keys, idx_t row_width) {
+			const auto data = UnifiedVectorFormat::GetData<T>(format);
+			for (idx_t row = 0; row < count; row++) {
+				const auto idx = format.sel->get_index(row);
+				if (format.validity.RowIsValid(idx)) {
+					Radix::EncodeData<T>(keys + row * row_width, data[idx]);
+				}
+			}
+		}
+
+		//! Encodes the sort keys of all rows of the set's chunk
+		void Encode(ReaderSet &set) const {
+			const auto count = set.chunk->size();
+			if (!set.keys) {
+				set.keys = make_unsafe_uniq_array<data_t>(STANDARD_VECTOR_SIZE * width);
+			}
+			set.keyFormats.resize(columns.size());
+			for (idx_t k = 0; k < columns.size(); k++) {
+				const auto &column = columns[k];
+				auto &format = set.keyFormats[k];
+				set.chunk->data[column.chunkIdx].ToUnifiedFormat(count, format);
+				const auto base = set.keys.get() + column.offset;
+				const data_t valid_byte = column.nulls_first ? 1 : 0;
+				for (idx_t row = 0; row < count; row++) {
+					const auto valid = format.validity.RowIsValid(format.sel->get_index(row));
+					base[row * width] = valid ? valid_byte : 1 - valid_byte;
+					memset(base + row * width + 1, 0, column.width);
+				}
+				const auto values = base + 1;
+				switch (column.type) {
+				case PhysicalType::BOOL:
+				case PhysicalType::INT8:
+					EncodeValues<int8_t>(format, count, values, width);
+					break;
+				case PhysicalType::INT16:
+					EncodeValues<int16_t>(format, count, values, width);
+					break;
+				case PhysicalType::INT32:
+					EncodeValues<int32_t>(format, count, values, width);
+					break;
+				case PhysicalType::INT64:
+					EncodeValues<int64_t>(format, count, values, width);
+					break;
+				case PhysicalType::UINT8:
+					EncodeValues<uint8_t>(format, count, values, width);
+					break;
+				case PhysicalType::UINT16:
+					EncodeValues<uint16_t>(format, count, values, width);
+					break;
+				case PhysicalType::UINT32:
+					EncodeValues<uint32_t>(format, count, values, width);
+					break;
+				case PhysicalType::UINT64:
+					EncodeValues<uint64_t>(format, count, values, width);
+					break;
+				case PhysicalType::INT128:
+					EncodeValues<hugeint_t>(format, count, values, width);
+					break;
+				case PhysicalType::FLOAT:
+					EncodeValues<float>(format, count, values, width);
+					break;
+				case PhysicalType::DOUBLE:
+					EncodeValues<double>(format, count, values, width);
+					break;
+				case PhysicalType::VARCHAR: {
+					const auto data = UnifiedVectorFormat::GetData<string_t>(format);
+					for (idx_t row = 0; row < count; row++) {
+						const auto idx = format.sel->get_index(row);
+						if (format.validity.RowIsValid(idx)) {
+							Radix::EncodeStringDataPrefix(values + row * width, data[idx], STRING_PREFIX);
+						}
+					}
+					break;
+				}
+				default:
+					throw InternalException("read_parquet_mergetree: cannot encode sort key type");
+				}
+				if (column.descending) {
+					for (idx_t row = 0; row < count; row++) {
+						auto value = values + row * width;
+						for (idx_t b = 0; b < column.width; b++) {
+							value[b] = ~value[b];
+						}
+					}
+				}
+			}
+		}
+
+		int Compare(const ReaderSet &l, idx_t l_row, const ReaderSet &r, idx_t r_row) const {
+			const auto l_key = l.keys.get() + l_row * width;
+			const auto r_key = r.keys.get() + r_row * width;
+			if (!hasStringPrefixes) {
+				return memcmp(l_key, r_key, width);
+			}
+			// a string prefix tie must be resolved before the columns behind it decide
+			for (idx_t k = 0; k < columns.size(); k++) {
+				const auto &column = columns[k];
+				const auto cmp = memcmp(l_key + column.offset, r_key + column.offset, 1 + column.width);
+				if (cmp != 0) {
+					return cmp;
+				}
+				if (column.type != PhysicalType::VARCHAR) {
+					continue;
+				}
+				const auto string_cmp = column.compare(l.keyFormats[k], l_row, r.keyFormats[k], r_row);
+				if (string_cmp != 0) {
+					return column.descending ? -string_cmp : string_cmp;
+				}
+			}
+			return 0;
+		}
+	};
+
+	//! Half-open slice [lo, hi) of the order-by key space merged by one thread, a missing bound is unbounded.
+	//! NULL keys sort last and therefore belong to the range without an upper bound. Point lookups use closed
+	//! ranges [k, k].
+	struct KeyRange {
+		Value lo;
+		Value hi;
+		bool hi_inclusive = false;
+	};
+
+	//! ClickHouse merge semantics applied to the rows sharing a sort key while they are merged
+	enum class MergeEngine : uint8_t {
+		NONE,
+		//! ReplacingMergeTree: keep the row with the highest version, the last merged row on ties
+		REPLACING,
+		//! CollapsingMergeTree: rows with sign -1 cancel rows with sign 1
+		COLLAPSING,
+		//! SummingMergeTree: sum the numeric columns outside the sort key
+		SUMMING
+	};
+
+	static MergeEngine ParseMergeEngine(const string &name) {
+		const auto lower = StringUtil::Lower(name);
+		if (lower == "replacing") {
+			return MergeEngine::REPLACING;
+		}
+		if (lower == "collapsing") {
+			return MergeEngine::COLLAPSING;
+		}
+		if (lower == "summing") {
+			return MergeEngine::SUMMING;
+		}
+		throw BinderException("read_parquet_mergetree: unknown engine \"%s\", expected 'replacing', 'collapsing' or 'summing'",
+							  name);
+	}
+
+	//! Whether the summing engine adds up a Parquet leaf. Booleans, dates, times and timestamps are stored as
+	//! numbers too, but like every column ClickHouse does not sum they keep the value of the group's first row.
+	static bool IsSummableLeaf(const duckdb_parquet::format::SchemaElement &el) {
+		using duckdb_parquet::format::ConvertedType;
+		if (el.type == Type::BOOLEAN) {
+			return false;
+		}
+		if (el.__isset.logicalType &&
+			(el.logicalType.__isset.DATE || el.logicalType.__isset.TIME || el.logicalType.__isset.TIMESTAMP)) {
+			return false;
+		}
+		if (el.__isset.converted_type) {
+			switch (el.converted_type) {
+			case ConvertedType::DATE:
+			case ConvertedType::TIME_MILLIS:
+			case ConvertedType::TIME_MICROS:
+			case ConvertedType::TIMESTAMP_MILLIS:
+			case ConvertedType::TIMESTAMP_MICROS:
+				return false;
+			default:
+				break;
+			}
+		}
+		return true;
+	}
+
+	static bool IsSummable(const LogicalType &type) {
+		switch (type.id()) {
+		case LogicalTypeId::TINYINT:
+		case LogicalTypeId::SMALLINT:
+		case LogicalTypeId::INTEGER:
+		case LogicalTypeId::BIGINT:
+		case LogicalTypeId::HUGEINT:
+		case LogicalTypeId::FLOAT:
+		case LogicalTypeId::DOUBLE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	//! Hands out key ranges in order, the range index doubles as batch index to preserve insertion order
+	struct OrderedReadGlobalState : GlobalTableFunctionState {
+		mutex lock;
+		vector<KeyRange> ranges;
+		idx_t next_range = 0;
+		//! Global column index of every scanned column, projected columns first and the order key last when
+		//! it is not projected. INVALID_INDEX stands for the row id column.
+		vector<idx_t> scanColumns;
+		vector<LogicalType> scanTypes;
+		//! Index of the first sort key column within scanColumns
+		idx_t keyColumn = DConstants::INVALID_INDEX;
+		//! Index of every sort key column within scanColumns
+		vector<idx_t> keyColumns;
+		//! Pushed down filters, keyed by index into scanColumns
+		optional_ptr<TableFilterSet> filters;
+		//! Late materialization: the merge reads the key, the filtered columns and the file row number,
+		//! which is placed behind the scanned columns
+		bool lateMaterialization = false;
+		idx_t rowNumberColumn = DConstants::INVALID_INDEX;
+		//! Late materialization: output columns the merge reads, copied from the merged chunks, and the other
+		//! output columns, decoded after the merge
+		vector<idx_t> mergedColumns;
+		vector<idx_t> payloadColumns;
+		//! Merge engine scans: index of the version or sign column within scanColumns and of the summed columns
+		idx_t engineColumn = DConstants::INVALID_INDEX;
+		vector<idx_t> sumColumns;
+		//! Merge engine scans only push filters on sort key columns below the merge. Filters on other columns
+		//! must see the merged rows, they are evaluated on the output instead.
+		TableFilterSet keyFilters;
+		TableFilterSet postFilters;
+
+		idx_t MaxThreads() const override {
+			return ranges.size();
+		}
+		//! Whether the merge decodes the scanned column even under late materialization
+		bool IsMergedColumn(idx_t col) const {
+			return std::find(keyColumns.begin(), keyColumns.end(), col) != keyColumns.end() ||
+				   (filters && filters->filters.count(col) > 0);
+		}
+		bool NextRange(idx_t &range_idx) {
+			lock_guard<mutex> guard(lock);
+			if (next_range >= ranges.size()) {
+				return false;
+			}
+			range_idx = next_range++;
+			return true;
+		}
 	};
 
 	struct OrderedReadFunctionData : FunctionData {
 		string orderBy;
+		vector<SortKeyColumn> sortKey;
 		vector<unique_ptr<ReaderSet>> sets;
 		vector<string> files;
 		vector<LogicalType> returnTypes;
 		vector<string> names;
+		//! Merge on the order key and a row locator only, decoding the other columns just for emitted rows
+		bool lateMaterialization = false;
+		//! Upper bound on the rows each key range emits, set from the limit parameter. It is no query limit: a
+		//! scan split into N key ranges (or looking up N keys) emits up to N times as many rows, the LIMIT of the
+		//! query still applies on top of it.
+		idx_t limit = DConstants::INVALID_INDEX;
+		MergeEngine engine = MergeEngine::NONE;
+		//! Version column of the replacing engine or sign column of the collapsing engine
+		string engineColumn;
+		idx_t engineColumnIdx = DConstants::INVALID_INDEX;
+		//! Per column: whether the summing engine adds it up, see IsSummableLeaf
+		vector<bool> summableColumns;
+		//! Time spent reading the footers in bind and the counters of the scan threads of this query, shown as
+		//! extra info by EXPLAIN ANALYZE
+		idx_t bindNanos = 0;
+		shared_ptr<ScanStatsTotals> queryStats = make_shared_ptr<ScanStatsTotals>();
+		//! Files grouped into runs of overlapping key ranges, in key order: every key of a run sorts before the
+		//! keys of the next run, so runs are concatenated and only the files within a run are merged
+		vector<vector<idx_t>> fileRuns;
+		//! Combined key range of every file run
+		vector<RowGroupKeyRange> runKeys;
 		unique_ptr<FunctionData> Copy() const override {
 			throw std::runtime_error("not implemented");
 		}
@@ -40,55 +622,864 @@ namespace duckdb {
 			if (!EqualStrArrays(o.files, files)) {
 				return false;
 			}
-			return this->orderBy ==  o.orderBy;
+			if (sortKey.size() != o.sortKey.size()) {
+				return false;
+			}
+			for (idx_t i = 0; i < sortKey.size(); i++) {
+				if (sortKey[i].name != o.sortKey[i].name || sortKey[i].descending != o.sortKey[i].descending ||
+					sortKey[i].nulls_first != o.sortKey[i].nulls_first) {
+					return false;
+				}
+			}
+			return this->orderBy ==  o.orderBy && engine == o.engine && engineColumn == o.engineColumn &&
+				   lateMaterialization == o.lateMaterialization && limit == o.limit;
 		};
 	};
 
 
 
+	//! Reads the page indexes and bloom filters of a file, which the footer only references by offset
+	struct ParquetIndexReader {
+		ParquetIndexReader(ClientContext &context, const string &path)
+			: allocator(Allocator::Get(context)),
+			  handle(FileSystem::GetFileSystem(context).OpenFile(path, FileFlags::FILE_FLAGS_READ)),
+			  transport(std::make_shared<ThriftFileTransport>(allocator, *handle, false)), protocol(transport) {
+		}
+
+		//! Whether the column index or the bloom filter of a column chunk proves that it lacks the key. Pages
+		//! of sorted files hold narrow key ranges, so the column index rules out keys falling between two pages.
+		bool ExcludesKey(const duckdb_parquet::format::ColumnChunk &chunk,
+						 const duckdb_parquet::format::SchemaElement &schema_ele, const LogicalType &type,
+						 const Value &key) {
+			if (chunk.__isset.column_index_offset) {
+				duckdb_parquet::format::ColumnIndex column_index;
+				transport->SetLocation(chunk.column_index_offset);
+				column_index.read(&protocol);
+				bool may_contain = false;
+				for (idx_t page = 0; page < column_index.null_pages.size() && !may_contain; page++) {
+					if (column_index.null_pages[page]) {
+						continue;
+					}
+					const auto min =
+						ParquetStatisticsUtils::ConvertValue(type, schema_ele, column_index.min_values[page]);
+					const auto max =
+						ParquetStatisticsUtils::ConvertValue(type, schema_ele, column_index.max_values[page]);
+					may_contain = min.IsNull() || max.IsNull() || (!(key < min) && !(max < key));
+				}
+				if (!may_contain) {
+					return true;
+				}
+			}
+			if (chunk.__isset.meta_data && chunk.meta_data.__isset.bloom_filter_offset &&
+				ParquetStatisticsUtils::BloomFilterSupported(type.id())) {
+				const ConstantFilter filter(ExpressionType::COMPARE_EQUAL, key);
+				return ParquetStatisticsUtils::BloomFilterExcludes(filter, chunk.meta_data, protocol, allocator);
+			}
+			return false;
+		}
+
+		Allocator &allocator;
+		unique_ptr<FileHandle> handle;
+		std::shared_ptr<ThriftFileTransport> transport;
+		duckdb_apache::thrift::protocol::TCompactProtocolT<ThriftFileTransport> protocol;
+	};
+
+	//! Sequential reader over one file fetching the rows emitted by a late materialized merge.
+	//! Row groups without requested rows are never decoded.
+	struct PayloadCursor {
+		unique_ptr<ParquetReader> reader;
+		unique_ptr<ParquetReaderScanState> scanState;
+		DataChunk chunk;
+		vector<idx_t> missingColumns;
+		//! File row number of the first row of every row group
+		vector<idx_t> rowGroupStarts;
+		idx_t group = DConstants::INVALID_INDEX;
+		//! File row number of the first row of the current chunk
+		idx_t chunkStart = 0;
+
+		//! Positions the cursor on the chunk holding the given file row
+		void Seek(ClientContext &context, idx_t row) {
+			if (group != DConstants::INVALID_INDEX && row >= chunkStart && row < chunkStart + chunk.size()) {
+				return;
+			}
+			const idx_t next_group =
+				std::upper_bound(rowGroupStarts.begin(), rowGroupStarts.end(), row) - rowGroupStarts.begin() - 1;
+			if (next_group != group || row < chunkStart) {
+				group = next_group;
+				scanState = make_uniq<ParquetReaderScanState>();
+				reader->InitializeScan(context, *scanState, {group});
+				chunkStart = rowGroupStarts[group];
+				chunk.Reset();
+			}
+			while (row >= chunkStart + chunk.size()) {
+				chunkStart += chunk.size();
+				chunk.Reset();
+				reader->Scan(*scanState, chunk);
+				if (chunk.size() == 0) {
+					throw InternalException("read_parquet_mergetree: row %llu is past the end of its row group", row);
+				}
+				for (const auto col : missingColumns) {
+					chunk.data[col].SetVectorType(VectorType::CONSTANT_VECTOR);
+					ConstantVector::SetNull(chunk.data[col], true);
+				}
+			}
+		}
+	};
+
+	//! Replaces the contents of a single row chunk with a row of the source chunk
+	static void CopyRow(DataChunk &source, idx_t row, DataChunk &target) {
+		target.Reset();
+		for (idx_t col = 0; col < target.ColumnCount(); col++) {
+			VectorOperations::Copy(source.data[col], target.data[col], row + 1, row, 0);
+		}
+		target.SetCardinality(1);
+	}
+
+	template <class T, class OP>
+	static void SumRow(Vector &sums, const UnifiedVectorFormat &source, idx_t row) {
+		const auto idx = source.sel->get_index(row);
+		if (!source.validity.RowIsValid(idx)) {
+			return;
+		}
+		const auto value = UnifiedVectorFormat::GetData<T>(source)[idx];
+		auto sum = FlatVector::GetData<T>(sums);
+		auto &sum_validity = FlatVector::Validity(sums);
+		if (!sum_validity.RowIsValid(0)) {
+			sum[0] = value;
+			sum_validity.SetValid(0);
+			return;
+		}
+		sum[0] = OP::template Operation<T, T, T>(sum[0], value);
+	}
+
+	template <class T>
+	static bool IsZeroSum(Vector &sums) {
+		return FlatVector::GetData<T>(sums)[0] == T(0);
+	}
+
+	static int64_t GetSign(const UnifiedVectorFormat &format, PhysicalType type, idx_t row) {
+		const auto idx = format.sel->get_index(row);
+		if (!format.validity.RowIsValid(idx)) {
+			return 0;
+		}
+		switch (type) {
+		case PhysicalType::INT8:
+			return UnifiedVectorFormat::GetData<int8_t>(format)[idx];
+		case PhysicalType::INT16:
+			return UnifiedVectorFormat::GetData<int16_t>(format)[idx];
+		case PhysicalType::INT32:
+			return UnifiedVectorFormat::GetData<int32_t>(format)[idx];
+		case PhysicalType::INT64:
+			return UnifiedVectorFormat::GetData<int64_t>(format)[idx];
+		default:
+			throw InternalException("read_parquet_mergetree: unsupported sign column type");
+		}
+	}
+
+	//! The key group a merge engine is folding: the merged rows sharing one sort key. A group can span chunks
+	//! and files, so the rows the engine keeps are copied out of the merged chunks.
+	struct MergeGroup {
+		MergeEngine engine = MergeEngine::NONE;
+		//! First row of the group, its normalized key detects the end of the group
+		ReaderSet head;
+		//! The row with the highest version, the last positive row or the running sums
+		DataChunk kept;
+		//! The first negative row of a collapsing group
+		DataChunk firstNegative;
+		bool active = false;
+		//! Positive minus negative rows of a collapsing group
+		int64_t sign = 0;
+		//! Whether the last row of a collapsing group with a sign was a state (positive) row
+		bool lastPositive = false;
+		//! Version or sign column within the scanned columns
+		idx_t engineColumn = DConstants::INVALID_INDEX;
+		PhysicalType engineType = PhysicalType::INVALID;
+		order_key_compare_t versionCompare = nullptr;
+		vector<idx_t> sumColumns;
+		vector<PhysicalType> sumTypes;
+		//! Unified views over the engine and the summed columns of the chunk being merged
+		UnifiedVectorFormat engineFormat;
+		vector<UnifiedVectorFormat> sumFormats;
+
+		void Initialize(ClientContext &context, MergeEngine engine_p, const OrderedReadGlobalState &glob_state) {
+			engine = engine_p;
+			head.chunk = make_uniq<DataChunk>();
+			head.chunk->Initialize(context, glob_state.scanTypes, 1);
+			kept.Initialize(context, glob_state.scanTypes, 1);
+			firstNegative.Initialize(context, glob_state.scanTypes, 1);
+			engineColumn = glob_state.engineColumn;
+			if (engineColumn != DConstants::INVALID_INDEX) {
+				const auto &type = glob_state.scanTypes[engineColumn];
+				engineType = type.InternalType();
+				if (engine == MergeEngine::REPLACING) {
+					versionCompare = GetOrderKeyComparator(type);
+				}
+			}
+			sumColumns = glob_state.sumColumns;
+			for (const auto col : sumColumns) {
+				sumTypes.push_back(glob_state.scanTypes[col].InternalType());
+			}
+			sumFormats.resize(sumColumns.size());
+		}
+
+		//! Refreshes the views over the chunk of the set whose run is merged next
+		void PrepareRun(ReaderSet &set) {
+			auto &chunk = *set.chunk;
+			if (engineColumn != DConstants::INVALID_INDEX) {
+				chunk.data[engineColumn].ToUnifiedFormat(chunk.size(), engineFormat);
+			}
+			for (idx_t i = 0; i < sumColumns.size(); i++) {
+				chunk.data[sumColumns[i]].ToUnifiedFormat(chunk.size(), sumFormats[i]);
+			}
+		}
+
+		//! Whether the row replaces the kept row: NULL versions only replace NULL versions
+		bool IsNewerVersion(idx_t row) {
+			UnifiedVectorFormat kept_format;
+			kept.data[engineColumn].ToUnifiedFormat(1, kept_format);
+			const auto kept_valid = kept_format.validity.RowIsValid(kept_format.sel->get_index(0));
+			if (!engineFormat.validity.RowIsValid(engineFormat.sel->get_index(row))) {
+				return !kept_valid;
+			}
+			return !kept_valid || versionCompare(kept_format, 0, engineFormat, row) <= 0;
+		}
+
+		void Sum(idx_t row) {
+			for (idx_t i = 0; i < sumColumns.size(); i++) {
+				auto &sums = kept.data[sumColumns[i]];
+				switch (sumTypes[i]) {
+				case PhysicalType::INT8:
+					SumRow<int8_t, AddOperatorOverflowCheck>(sums, sumFormats[i], row);
+					break;
+				case PhysicalType::INT16:
+					SumRow<int16_t, AddOperatorOverflowCheck>(sums, sumFormats[i], row);
+					break;
+				case PhysicalType::INT32:
+					SumRow<int32_t, AddOperatorOverflowCheck>(sums, sumFormats[i], row);
+					break;
+				case PhysicalType::INT64:
+					SumRow<int64_t, AddOperatorOverflowCheck>(sums, sumFormats[i], row);
+					break;
+				case PhysicalType::INT128:
+					SumRow<hugeint_t, AddOperatorOverflowCheck>(sums, sumFormats[i], row);
+					break;
+				case PhysicalType::FLOAT:
+					SumRow<float, AddOperator>(sums, sumFormats[i], row);
+					break;
+				case PhysicalType::DOUBLE:
+					SumRow<double, AddOperator>(sums, sumFormats[i], row);
+					break;
+				default:
+					throw InternalException("read_parquet_mergetree: unsupported summed column type");
+				}
+			}
+		}
+
+		//! Whether every summed column of the group adds up to zero, a NULL sum counts as a value
+		bool SumsAreZero() {
+			for (idx_t i = 0; i < sumColumns.size(); i++) {
+				auto &sums = kept.data[sumColumns[i]];
+				if (!FlatVector::Validity(sums).RowIsValid(0)) {
+					return false;
+				}
+				bool zero;
+				switch (sumTypes[i]) {
+				case PhysicalType::INT8:
+					zero = IsZeroSum<int8_t>(sums);
+					break;
+				case PhysicalType::INT16:
+					zero = IsZeroSum<int16_t>(sums);
+					break;
+				case PhysicalType::INT32:
+					zero = IsZeroSum<int32_t>(sums);
+					break;
+				case PhysicalType::INT64:
+					zero = IsZeroSum<int64_t>(sums);
+					break;
+				case PhysicalType::INT128:
+					zero = IsZeroSum<hugeint_t>(sums);
+					break;
+				case PhysicalType::FLOAT:
+					zero = IsZeroSum<float>(sums);
+					break;
+				case PhysicalType::DOUBLE:
+					zero = IsZeroSum<double>(sums);
+					break;
+				default:
+					throw InternalException("read_parquet_mergetree: unsupported summed column type");
+				}
+				if (!zero) {
+					return false;
+				}
+			}
+			return !sumColumns.empty();
+		}
+
+		//! Folds a merged row into the group, starting a new group when none is active
+		void Add(const SortKeyLayout &layout, ReaderSet &set, idx_t row) {
+			const bool first = !active;
+			if (first) {
+				CopyRow(*set.chunk, row, *head.chunk);
+				layout.Encode(head);
+				active = true;
+				sign = 0;
+				lastPositive = false;
+			}
+			switch (engine) {
+			case MergeEngine::REPLACING:
+				if (first || engineColumn == DConstants::INVALID_INDEX || IsNewerVersion(row)) {
+					CopyRow(*set.chunk, row, kept);
+				}
+				break;
+			case MergeEngine::COLLAPSING: {
+				if (first) {
+					firstNegative.Reset();
+				}
+				const auto row_sign = GetSign(engineFormat, engineType, row);
+				if (row_sign > 0) {
+					CopyRow(*set.chunk, row, kept);
+					sign++;
+					lastPositive = true;
+				} else if (row_sign < 0) {
+					if (firstNegative.size() == 0) {
+						CopyRow(*set.chunk, row, firstNegative);
+					}
+					sign--;
+					lastPositive = false;
+				}
+				break;
+			}
+			case MergeEngine::SUMMING:
+				if (first) {
+					CopyRow(*set.chunk, row, kept);
+				} else {
+					Sum(row);
+				}
+				break;
+			default:
+				throw InternalException("read_parquet_mergetree: no merge engine");
+			}
+		}
+
+		//! Most rows Emit writes for one group
+		idx_t MaxEmitRows() const {
+			return engine == MergeEngine::COLLAPSING ? 2 : 1;
+		}
+
+		//! Ends the group, writing the rows it collapses to at out_idx. Returns the number of rows written.
+		idx_t Emit(DataChunk &output, idx_t out_idx) {
+			active = false;
+			if (engine == MergeEngine::COLLAPSING) {
+				// as ClickHouse: the last positive row survives a surplus of positive rows, the first
+				// negative row a surplus of negative ones. A balanced group vanishes when it ends on a
+				// negative row, otherwise it keeps both the first negative and the last positive row.
+				idx_t count = 0;
+				if (sign < 0 || (sign == 0 && lastPositive)) {
+					EmitRow(firstNegative, output, out_idx + count++);
+				}
+				if (sign > 0 || (sign == 0 && lastPositive)) {
+					EmitRow(kept, output, out_idx + count++);
+				}
+				return count;
+			}
+			if (engine == MergeEngine::SUMMING && SumsAreZero()) {
+				// as ClickHouse: a group whose summed columns all add up to zero is dropped
+				return 0;
+			}
+			EmitRow(kept, output, out_idx);
+			return 1;
+		}
+
+		static void EmitRow(DataChunk &source, DataChunk &output, idx_t out_idx) {
+			for (idx_t col = 0; col < output.ColumnCount(); col++) {
+				VectorOperations::Copy(source.data[col], output.data[col], 1, 0, out_idx);
+			}
+		}
+	};
+
+	//! k-way merge state: a binary min-heap of set indexes keyed by the current row of each set.
+	//! Exhausted sets are dropped from the heap, so every output row costs O(log files) comparisons.
 	struct  OrderedReadLocalState: LocalTableFunctionState {
 		vector<unique_ptr<ReaderSet>> sets;
-		vector<idx_t> winner_group;
-		void RecalculateWinnerGroup() {
-			winner_group.clear();
-			if (sets.empty()) {
+		vector<idx_t> heap;
+		//! Compares the first sort key column against the key range bounds
+		order_key_compare_t compare = nullptr;
+		SortKeyLayout layout;
+		//! The last output referenced the top chunk without copying, refill it before the next merge step
+		bool refill_top = false;
+		idx_t range_idx = 0;
+		//! Row 0 holds the lower bound, row 1 the upper bound of the current key range
+		DataChunk bounds;
+		UnifiedVectorFormat boundsFormat;
+		bool has_lo = false;
+		bool has_hi = false;
+		bool hi_inclusive = false;
+		optional_ptr<TableFilterSet> filters;
+		//! Rows emitted from the current key range, bounded by the limit parameter
+		idx_t range_emitted = 0;
+		//! Late materialization: file and file row of every row of the output being built
+		idx_t locatorFiles[STANDARD_VECTOR_SIZE];
+		int64_t locatorRows[STANDARD_VECTOR_SIZE];
+		unordered_map<idx_t, unique_ptr<PayloadCursor>> payload;
+		DataChunk staging;
+		//! Point lookups: the index reader of every file whose page indexes or bloom filters were read, by file
+		unordered_map<idx_t, unique_ptr<ParquetIndexReader>> indexReaders;
+		//! Merge engine scans: the key group being folded, it may continue in the next output chunk
+		MergeGroup group;
+		//! Next file run to open for the current key range, INVALID_INDEX when the range is done
+		idx_t nextRun = DConstants::INVALID_INDEX;
+		PrefetchSettings prefetchSettings;
+		//! The pool the prefetches of the sets submit to, kept alive until they are cancelled
+		shared_ptr<PrefetchPool> prefetchPool;
+		//! Counters of this thread, added to the database totals when the scan is done
+		ScanStats stats;
+		mutable idx_t comparisons = 0;
+		shared_ptr<ScanStatsTotals> statsTotals;
+		shared_ptr<ScanStatsTotals> queryStats;
+
+		~OrderedReadLocalState() override {
+			// cancel the prefetches while the pool they submit to is alive
+			sets.clear();
+			if (statsTotals) {
+				stats.Add(ScanCounter::COMPARISONS, comparisons);
+				statsTotals->Add(stats);
+				queryStats->Add(stats);
+			}
+		}
+
+		//! Drops the rest of the current key range
+		void EndRange() {
+			heap.clear();
+			sets.clear();
+			nextRun = DConstants::INVALID_INDEX;
+		}
+		void SetBounds(const KeyRange &range) {
+			has_lo = !range.lo.IsNull();
+			has_hi = !range.hi.IsNull();
+			hi_inclusive = range.hi_inclusive;
+			bounds.Reset();
+			bounds.SetValue(0, 0, range.lo);
+			bounds.SetValue(0, 1, range.hi);
+			bounds.SetCardinality(2);
+			bounds.data[0].ToUnifiedFormat(2, boundsFormat);
+		}
+		//! First row in [begin, end) of the set's chunk that does not sort before the given bound
+		idx_t LowerBound(const ReaderSet &set, idx_t begin, idx_t end, idx_t bound_row) const {
+			while (begin < end) {
+				const auto mid = begin + (end - begin) / 2;
+				if (compare(set.orderByFormat, mid, boundsFormat, bound_row) < 0) {
+					begin = mid + 1;
+				} else {
+					end = mid;
+				}
+			}
+			return begin;
+		}
+		//! First row in [begin, end) of the set's chunk that sorts after the given bound
+		idx_t UpperBound(const ReaderSet &set, idx_t begin, idx_t end, idx_t bound_row) const {
+			while (begin < end) {
+				const auto mid = begin + (end - begin) / 2;
+				if (compare(set.orderByFormat, mid, boundsFormat, bound_row) <= 0) {
+					begin = mid + 1;
+				} else {
+					end = mid;
+				}
+			}
+			return begin;
+		}
+		//! Compacts the rows [result_idx, end_idx) of the set's chunk to the ones passing the pushed down filters
+		void ApplyFilters(ReaderSet &set) {
+			auto &chunk = *set.chunk;
+			SelectionVector sel(STANDARD_VECTOR_SIZE);
+			idx_t count = 0;
+			for (idx_t row = set.result_idx; row < set.end_idx; row++) {
+				sel.set_index(count++, row);
+			}
+			const auto total = count;
+			for (auto &entry : filters->filters) {
+				count = SelectTableFilter(chunk.data[entry.first], chunk.size(), *entry.second, sel, count);
+			}
+			if (count == total && set.result_idx == 0 && set.end_idx == chunk.size()) {
 				return;
 			}
-			idx_t winner_idx = 0;
-			for (idx_t i = 1; i < sets.size(); i++) {
-				const auto &s = sets[i];
-				const auto &w = sets[winner_idx];
-				if (s->chunk->GetValue(s->orderByIdx, s->result_idx) <
-					w->chunk->GetValue(w->orderByIdx, w->result_idx)) {
-					winner_idx = i;
-					}
+			chunk.Slice(sel, count);
+			chunk.Flatten();
+			set.result_idx = 0;
+			set.end_idx = count;
+			chunk.data[set.orderByIdx].ToUnifiedFormat(count, set.orderByFormat);
+		}
+		//! Scans the next chunk of the set and trims it to the current key range
+		bool Refill(ReaderSet &set) {
+			while (!set.past_range) {
+				const auto decode_start = ScanStats::Now();
+				const auto scanned = set.ScanNext(stats);
+				stats.AddElapsed(ScanCounter::DECODE_NANOS, decode_start);
+				if (!scanned) {
+					break;
+				}
+				stats.Add(ScanCounter::CHUNKS_DECODED);
+				if (has_hi) {
+					set.end_idx = hi_inclusive ? UpperBound(set, 0, set.chunk->size(), 1)
+											   : LowerBound(set, 0, set.chunk->size(), 1);
+					set.past_range = set.end_idx < set.chunk->size();
+				}
+				if (has_lo) {
+					set.result_idx = LowerBound(set, 0, set.end_idx, 0);
+				}
+				if (filters && !set.Exhausted()) {
+					ApplyFilters(set);
+				}
+				if (!set.Exhausted()) {
+					layout.Encode(set);
+					return true;
+				}
 			}
-			winner_group.push_back(winner_idx);
-			auto &w = sets[winner_idx];
-			const auto &wLast = w->chunk->GetValue(w->orderByIdx, w->chunk->size()-1);
+			set.StopPrefetch();
+			set.reader.reset();
+			return false;
+		}
+
+		//! Strict weak ordering of two sets by their current rows, ties broken by set index for a stable merge
+		bool SetLess(idx_t a, idx_t b) const {
+			const auto &l = *sets[a];
+			const auto &r = *sets[b];
+			comparisons++;
+			const auto cmp = layout.Compare(l, l.result_idx, r, r.result_idx);
+			return cmp < 0 || (cmp == 0 && a < b);
+		}
+		void SiftDown(idx_t pos) {
+			const auto size = heap.size();
+			while (true) {
+				auto smallest = pos;
+				const auto left = 2 * pos + 1;
+				const auto right = left + 1;
+				if (left < size && SetLess(heap[left], heap[smallest])) {
+					smallest = left;
+				}
+				if (right < size && SetLess(heap[right], heap[smallest])) {
+					smallest = right;
+				}
+				if (smallest == pos) {
+					return;
+				}
+				std::swap(heap[pos], heap[smallest]);
+				pos = smallest;
+			}
+		}
+		void BuildHeap() {
+			heap.clear();
 			for (idx_t i = 0; i < sets.size(); i++) {
-				if (i == winner_idx)  continue;
-				auto &s = sets[i];
-				const auto &sFirst = s->chunk->GetValue(s->orderByIdx, s->result_idx);
-				if (sFirst <= wLast) {
-					winner_group.push_back(i);
+				if (!sets[i]->Exhausted()) {
+					heap.push_back(i);
 				}
 			}
+			for (idx_t i = heap.size() / 2; i > 0; i--) {
+				SiftDown(i - 1);
+			}
+		}
+		//! Index of the set holding the second smallest row, or INVALID_INDEX when the top is alone
+		idx_t RunnerUp() const {
+			if (heap.size() < 2) {
+				return DConstants::INVALID_INDEX;
+			}
+			if (heap.size() == 2 || SetLess(heap[1], heap[2])) {
+				return heap[1];
+			}
+			return heap[2];
+		}
+		//! End of the run of the top set: rows [result_idx, RunEnd) all sort before the runner-up's current row.
+		//! Rows within a chunk are sorted, so the boundary is found by galloping followed by a binary search.
+		idx_t RunEnd(idx_t runner_up) const {
+			const auto top_idx = heap[0];
+			const auto &top = *sets[top_idx];
+			const auto size = top.end_idx;
+			if (runner_up == DConstants::INVALID_INDEX) {
+				return size;
+			}
+			const auto &runner = *sets[runner_up];
+			auto before_runner = [&](idx_t row) {
+				comparisons++;
+				const auto cmp = layout.Compare(top, row, runner, runner.result_idx);
+				return cmp < 0 || (cmp == 0 && top_idx < runner_up);
+			};
+			idx_t known = top.result_idx;
+			idx_t limit = size;
+			for (idx_t step = 1; known + step < size; step *= 2) {
+				if (!before_runner(known + step)) {
+					limit = known + step;
+					break;
+				}
+				known += step;
+			}
+			idx_t lo = known + 1;
+			while (lo < limit) {
+				const auto mid = lo + (limit - lo) / 2;
+				if (before_runner(mid)) {
+					lo = mid + 1;
+				} else {
+					limit = mid;
+				}
+			}
+			return lo;
+		}
+		//! Refills the top set after it was advanced and restores the heap property
+		void FixTop() {
+			auto &top = *sets[heap[0]];
+			if (top.Exhausted() && !Refill(top)) {
+				heap[0] = heap.back();
+				heap.pop_back();
+			}
+			if (!heap.empty()) {
+				SiftDown(0);
+			}
+		}
+	};
+
+
+	//! Schema elements of the leaf columns, indexed by file column
+	static vector<const duckdb_parquet::format::SchemaElement *> GetLeafSchema(const ParquetReader &reader) {
+		vector<const duckdb_parquet::format::SchemaElement *> leaves;
+		for (auto &el : reader.metadata->metadata->schema) {
+			if (el.num_children == 0) {
+				leaves.push_back(&el);
+			}
+		}
+		return leaves;
+	}
+
+	//! Footer min/max statistics of one column chunk
+	static RowGroupKeyRange ReadColumnChunkRange(const duckdb_parquet::format::RowGroup &rg, idx_t file_col,
+												 const duckdb_parquet::format::SchemaElement &schema_ele,
+												 const LogicalType &type) {
+		RowGroupKeyRange range;
+		range.rows = rg.num_rows;
+		if (file_col < rg.columns.size() && rg.columns[file_col].__isset.meta_data &&
+			rg.columns[file_col].meta_data.__isset.statistics) {
+			const auto &stats = rg.columns[file_col].meta_data.statistics;
+			if (stats.__isset.min_value && stats.__isset.max_value) {
+				range.min = ParquetStatisticsUtils::ConvertValue(type, schema_ele, stats.min_value);
+				range.max = ParquetStatisticsUtils::ConvertValue(type, schema_ele, stats.max_value);
+				range.has_stats = !range.min.IsNull() && !range.max.IsNull();
+			}
+			range.may_have_nulls = !stats.__isset.null_count || stats.null_count > 0;
+		}
+		return range;
+	}
+
+	//! Reads the footer min/max statistics of the order-by column for every row group of the file
+	static void ReadRowGroupKeyRanges(const ParquetReader &reader, const duckdb_parquet::format::SchemaElement &schema_ele,
+									  const LogicalType &type, ReaderSet &set) {
+		for (auto &rg : reader.metadata->metadata->row_groups) {
+			set.rowGroupKeys.push_back(ReadColumnChunkRange(rg, set.orderByColumn, schema_ele, type));
+		}
+	}
+
+	//! Whether the column chunk statistics prove that no row of the row group passes the filter
+	static bool FilterExcludesRange(const TableFilter &filter, const LogicalType &type, const RowGroupKeyRange &range) {
+		if (!range.has_stats) {
+			return false;
+		}
+		auto stats = BaseStatistics::CreateEmpty(type);
+		switch (stats.GetStatsType()) {
+		case StatisticsType::NUMERIC_STATS:
+			NumericStats::SetMin(stats, range.min);
+			NumericStats::SetMax(stats, range.max);
+			break;
+		case StatisticsType::STRING_STATS:
+			StringStats::Update(stats, string_t(StringValue::Get(range.min)));
+			StringStats::Update(stats, string_t(StringValue::Get(range.max)));
+			break;
+		default:
+			return false;
+		}
+		stats.SetHasNoNull();
+		if (range.may_have_nulls) {
+			stats.SetHasNull();
+		}
+		return filter.CheckStatistics(stats) == FilterPropagateResult::FILTER_ALWAYS_FALSE;
+	}
+
+	//! Splits the key space into up to max_ranges slices of roughly equal row counts, in ascending key order
+	//! whatever the sort direction, using the row group minimums as split points. Without statistics for every
+	//! row group the whole key space stays one range.
+	static vector<KeyRange> CutKeyRanges(const OrderedReadFunctionData &bindData, idx_t max_ranges) {
+		vector<KeyRange> ranges;
+		vector<const RowGroupKeyRange *> row_groups;
+		idx_t total_rows = 0;
+		for (auto &set : bindData.sets) {
+			for (auto &rg : set->rowGroupKeys) {
+				if (!rg.has_stats) {
+					max_ranges = 1;
+				}
+				row_groups.push_back(&rg);
+				total_rows += rg.rows;
+			}
+		}
+		max_ranges = MinValue<idx_t>(max_ranges, row_groups.size());
+		KeyRange current;
+		if (max_ranges > 1) {
+			std::sort(row_groups.begin(), row_groups.end(),
+					  [](const RowGroupKeyRange *a, const RowGroupKeyRange *b) { return a->min < b->min; });
+			const auto target = MaxValue<idx_t>(total_rows / max_ranges, 1);
+			idx_t accumulated = 0;
+			for (auto &rg : row_groups) {
+				if (accumulated >= target && ranges.size() + 1 < max_ranges &&
+					(current.lo.IsNull() || current.lo < rg->min)) {
+					current.hi = rg->min;
+					ranges.push_back(current);
+					current.lo = rg->min;
+					accumulated = 0;
+				}
+				accumulated += rg->rows;
+			}
+		}
+		current.hi = Value();
+		ranges.push_back(current);
+		return ranges;
+	}
+
+	//! Key ranges scanned one after another or by separate threads. The scan emits them in ascending key order
+	//! with NULLs last, so other orders stay one range.
+	static vector<KeyRange> PartitionKeyRanges(const OrderedReadFunctionData &bindData, idx_t max_ranges) {
+		if (bindData.sortKey[0].descending || bindData.sortKey[0].nulls_first) {
+			max_ranges = 1;
+		}
+		return CutKeyRanges(bindData, max_ranges);
+	}
+
+	//! Key range of a whole file, combined from the statistics of its row groups
+	static RowGroupKeyRange FileKeyRange(const ReaderSet &set) {
+		RowGroupKeyRange file;
+		file.has_stats = true;
+		file.may_have_nulls = false;
+		for (auto &rg : set.rowGroupKeys) {
+			if (rg.rows == 0) {
+				continue;
+			}
+			if (!rg.has_stats) {
+				file.has_stats = false;
+				break;
+			}
+			if (file.rows == 0 || rg.min < file.min) {
+				file.min = rg.min;
+			}
+			if (file.rows == 0 || file.max < rg.max) {
+				file.max = rg.max;
+			}
+			file.may_have_nulls = file.may_have_nulls || rg.may_have_nulls;
+			file.rows += rg.rows;
+		}
+		return file;
+	}
+
+	//! Groups the files into runs whose key ranges overlap: files are sorted by their minimum key and a file
+	//! starts a new run when its minimum exceeds the maximum of the run so far. Time partitioned parts usually
+	//! end up as runs of one file each, which are streamed without merging. Files may hold NULL keys, sorted
+	//! last, so such a file extends its run to the end of the key space. Without statistics for every file all
+	//! files form one run.
+	static vector<vector<idx_t>> GroupFileRuns(const OrderedReadFunctionData &bindData) {
+		vector<vector<idx_t>> runs;
+		vector<RowGroupKeyRange> ranges;
+		vector<idx_t> order;
+		// runs are laid out in ascending key order with NULLs last
+		bool disjoint = !bindData.sortKey[0].descending && !bindData.sortKey[0].nulls_first;
+		for (idx_t i = 0; i < bindData.sets.size(); i++) {
+			ranges.push_back(FileKeyRange(*bindData.sets[i]));
+			if (!ranges.back().has_stats) {
+				disjoint = false;
+			}
+			if (ranges.back().rows > 0) {
+				order.push_back(i);
+			}
+		}
+		if (!disjoint) {
+			runs.emplace_back();
+			for (idx_t i = 0; i < bindData.sets.size(); i++) {
+				runs.back().push_back(i);
+			}
+			return runs;
+		}
+		std::stable_sort(order.begin(), order.end(),
+						 [&](idx_t a, idx_t b) { return ranges[a].min < ranges[b].min; });
+		Value run_max;
+		bool run_unbounded = false;
+		for (const auto idx : order) {
+			const auto &range = ranges[idx];
+			if (runs.empty() || (!run_unbounded && run_max < range.min)) {
+				runs.emplace_back();
+				run_max = range.max;
+				run_unbounded = false;
+			} else if (run_max < range.max) {
+				run_max = range.max;
+			}
+			run_unbounded = run_unbounded || range.may_have_nulls;
+			runs.back().push_back(idx);
+		}
+		for (auto &run : runs) {
+			// equal keys of overlapping files are merged in file order
+			std::sort(run.begin(), run.end());
+		}
+		return runs;
+	}
+
+	//! Key range of a file run, combined from the key ranges of its files
+	static RowGroupKeyRange RunKeyRange(const OrderedReadFunctionData &bindData, const vector<idx_t> &run) {
+		RowGroupKeyRange result;
+		result.has_stats = true;
+		result.may_have_nulls = false;
+		for (const auto idx : run) {
+			const auto file = FileKeyRange(*bindData.sets[idx]);
+			if (!file.has_stats) {
+				result.has_stats = false;
+				break;
+			}
+			if (file.rows == 0) {
+				continue;
+			}
+			if (result.rows == 0 || file.min < result.min) {
+				result.min = file.min;
+			}
+			if (result.rows == 0 || result.max < file.max) {
+				result.max = file.max;
+			}
+			result.may_have_nulls = result.may_have_nulls || file.may_have_nulls;
+			result.rows += file.rows;
+		}
+		return result;
+	}
+
+	//! Whether every key of a file run sorts after the range. Runs are laid out in key order, so no later run
+	//! overlaps the range either.
+	static bool RunFollowsRange(const RowGroupKeyRange &run, const KeyRange &range) {
+		if (!run.has_stats || run.min.IsNull() || range.hi.IsNull()) {
+			return false;
+		}
+		return range.hi_inclusive ? range.hi < run.min : !(run.min < range.hi);
+	}
+
+	//! Whether a row group may hold keys of the range
+	static bool RowGroupOverlapsRange(const RowGroupKeyRange &rg, const KeyRange &range) {
+		if (!rg.has_stats) {
+			return true;
+		}
+		if (range.hi.IsNull() && rg.may_have_nulls) {
+			return true;
 		}
-		void RemoveSetGracefully(const idx_t idx) {
-			if (idx != sets.size() - 1) {
-				sets[idx].reset(sets[sets.size() - 1].release());
-			}
-			sets.pop_back();
+		if (!range.lo.IsNull() && rg.max < range.lo) {
+			return false;
 		}
-	};
-
+		if (range.hi.IsNull()) {
+			return true;
+		}
+		return range.hi_inclusive ? !(range.hi < rg.min) : rg.min < range.hi;
+	}
 
-	static unique_ptr<FunctionData> OrderedParquetScanBind(ClientContext &context, TableFunctionBindInput &input,
-														vector<LogicalType> &return_types, vector<string> &names) {
-		Connection conn(*context.db);
-		auto res = make_uniq<OrderedReadFunctionData>();
-		auto files = ListValue::GetChildren(input.inputs[0]);
+	//! Expands the file globs and reads the footers of all files: the union schema, the sort key columns and
+	//! the per row group statistics of the leading sort key
+	static void BindOrderedFiles(ClientContext &context, const Value &files_value, OrderedReadFunctionData &res,
+								 vector<LogicalType> &return_types, vector<string> &names) {
+		const auto bind_start = ScanStats::Now();
+		const auto &files = ListValue::GetChildren(files_value);
 		vector<string> fileNames;
 		for (auto & file : files) {
 			fileNames.push_back(file.ToString());
@@ -104,16 +1495,15 @@ namespace duckdb {
 		if (unglobbedFileList.empty()) {
 		    throw duckdb::InvalidInputException("No files matched the provided pattern.");
 		}
-
-		res->orderBy = input.inputs[1].GetValue<string>();
 		for (auto & file : unglobbedFileList) {
 			auto set = make_uniq<ReaderSet>();
-			res->files.push_back(file);
+			res.files.push_back(file);
 			ParquetOptions po;
 			po.binary_as_string = true;
-			ParquetReader reader(context, file, po, nullptr);
+			auto reader = OpenCachedParquetReader(context, file, po);
 			set->columnMap = vector<idx_t>();
-			for (auto &el : reader.metadata->metadata->schema) {
+			const duckdb_parquet::format::SchemaElement *orderByElement = nullptr;
+			for (auto &el : reader->metadata->metadata->schema) {
 				if (el.num_children != 0) {
 					continue;
 				}
@@ -144,146 +1534,1044 @@ namespace duckdb {
 						break;;
 				}
 				set->columnMap.push_back(name_it - names.begin());
-				if (el.name == res->orderBy) {
+				if (el.name == res.sortKey[0].name) {
 					set->orderByIdx = name_it - names.begin();
+					set->orderByColumn = set->columnMap.size() - 1;
+					orderByElement = &el;
 				}
+				const bool summable = IsSummable(return_type) && IsSummableLeaf(el);
 				if (name_it != names.end()) {
 					if (return_types[name_it - names.begin()] != return_type) {
 						throw std::runtime_error("incompatible schema");
 					}
+					// a column is summed only when every file stores it as a plain number
+					if (!summable) {
+						res.summableColumns[name_it - names.begin()] = false;
+					}
 					continue;
 				}
 				return_types.push_back(return_type);
 				names.push_back(el.name);
+				res.summableColumns.push_back(summable);
+			}
+			for (auto &key : res.sortKey) {
+				auto name_it = std::find(names.begin(), names.end(), key.name);
+				if (name_it == names.end() ||
+					std::find(set->columnMap.begin(), set->columnMap.end(), name_it - names.begin()) == set->columnMap.end()) {
+					throw BinderException("read_parquet_mergetree: order by column \"%s\" not found in %s", key.name, file);
+				}
+				key.globalIdx = name_it - names.begin();
+			}
+			ReadRowGroupKeyRanges(*reader, *orderByElement, return_types[set->orderByIdx], *set);
+			res.sets.push_back(std::move(set));
+		}
+		res.fileRuns = GroupFileRuns(res);
+		for (auto &run : res.fileRuns) {
+			res.runKeys.push_back(RunKeyRange(res, run));
+		}
+		ScanStats stats;
+		stats.Add(ScanCounter::FILES_BOUND, res.files.size());
+		stats.AddElapsed(ScanCounter::BIND_NANOS, bind_start);
+		ScanStatsTotals::Get(context)->Add(stats);
+		res.bindNanos = stats.Get(ScanCounter::BIND_NANOS);
+	}
+
+	//! Binds an ordered scan of the files: the sort key, the scan options among the named parameters and the
+	//! footers of the files. Shared by read_parquet_mergetree and mergetree_compact.
+	static void BindOrderedScan(ClientContext &context, const Value &files, const string &order_by,
+								const named_parameter_map_t &named_parameters, OrderedReadFunctionData &res,
+								vector<LogicalType> &return_types, vector<string> &names) {
+		res.orderBy = order_by;
+		res.sortKey = ParseSortKey(res.orderBy);
+		for (auto &param : named_parameters) {
+			if (param.first == "late_materialization") {
+				res.lateMaterialization = BooleanValue::Get(param.second);
+			} else if (param.first == "limit") {
+				res.limit = param.second.GetValue<idx_t>();
+			} else if (param.first == "engine") {
+				res.engine = ParseMergeEngine(StringValue::Get(param.second));
+			}
+		}
+		for (auto &param : named_parameters) {
+			if (param.first != "version" && param.first != "sign") {
+				continue;
+			}
+			const auto expected = param.first == "version" ? MergeEngine::REPLACING : MergeEngine::COLLAPSING;
+			if (res.engine != expected) {
+				throw BinderException("read_parquet_mergetree: %s requires engine := '%s'", param.first,
+									  param.first == "version" ? "replacing" : "collapsing");
+			}
+			res.engineColumn = StringValue::Get(param.second);
+		}
+		if (res.engine == MergeEngine::COLLAPSING && res.engineColumn.empty()) {
+			throw BinderException("read_parquet_mergetree: engine 'collapsing' requires a sign column");
+		}
+		if (res.engine != MergeEngine::NONE && res.lateMaterialization) {
+			throw BinderException("read_parquet_mergetree: late_materialization cannot be combined with a merge engine");
+		}
+		BindOrderedFiles(context, files, res, return_types, names);
+		if (!res.engineColumn.empty()) {
+			auto name_it = std::find(names.begin(), names.end(), res.engineColumn);
+			if (name_it == names.end()) {
+				throw BinderException("read_parquet_mergetree: column \"%s\" not found", res.engineColumn);
+			}
+			res.engineColumnIdx = name_it - names.begin();
+			if (res.engine == MergeEngine::COLLAPSING && !return_types[res.engineColumnIdx].IsIntegral()) {
+				throw BinderException("read_parquet_mergetree: sign column \"%s\" must be an integer column",
+									  res.engineColumn);
 			}
-			res->sets.push_back(std::move(set));
 		}
-		res->returnTypes = return_types;
-		res->names = names;
+		res.returnTypes = return_types;
+		res.names = names;
+	}
+
+	static unique_ptr<FunctionData> OrderedParquetScanBind(ClientContext &context, TableFunctionBindInput &input,
+														vector<LogicalType> &return_types, vector<string> &names) {
+		auto res = make_uniq<OrderedReadFunctionData>();
+		BindOrderedScan(context, input.inputs[0], input.inputs[1].GetValue<string>(), input.named_parameters, *res,
+						return_types, names);
 		return std::move(res);
 	}
 
-	static unique_ptr<LocalTableFunctionState>
-	ParquetScanInitLocal(ExecutionContext &context, TableFunctionInitInput &input, GlobalTableFunctionState *gstate_p) {
-		auto res = make_uniq<OrderedReadLocalState>();
+	//! Most keys a filter on the leading sort key may list for the scan to look them up one by one
+	static constexpr idx_t MAX_LOOKUP_KEYS = 1024;
+
+	//! Collects the keys a filter restricts its column to: `key = x`, and `key IN (...)` which arrives as an
+	//! optional filter over equalities. Returns false when the filter admits other keys.
+	static bool CollectLookupKeys(const TableFilter &filter, vector<Value> &keys) {
+		switch (filter.filter_type) {
+		case TableFilterType::CONSTANT_COMPARISON: {
+			auto &constant_filter = filter.Cast<ConstantFilter>();
+			if (constant_filter.comparison_type != ExpressionType::COMPARE_EQUAL) {
+				return false;
+			}
+			keys = {constant_filter.constant};
+			return true;
+		}
+		case TableFilterType::CONJUNCTION_OR: {
+			vector<Value> result;
+			for (auto &child : filter.Cast<ConjunctionOrFilter>().child_filters) {
+				vector<Value> child_keys;
+				if (!CollectLookupKeys(*child, child_keys)) {
+					return false;
+				}
+				result.insert(result.end(), child_keys.begin(), child_keys.end());
+				if (result.size() > MAX_LOOKUP_KEYS) {
+					return false;
+				}
+			}
+			keys = std::move(result);
+			return true;
+		}
+		case TableFilterType::CONJUNCTION_AND: {
+			// children without keys, like the range filter that accompanies an IN list, only drop rows
+			bool found = false;
+			for (auto &child : filter.Cast<ConjunctionAndFilter>().child_filters) {
+				vector<Value> child_keys;
+				if (!CollectLookupKeys(*child, child_keys)) {
+					continue;
+				}
+				if (!found) {
+					keys = std::move(child_keys);
+					found = true;
+					continue;
+				}
+				vector<Value> common;
+				for (auto &key : keys) {
+					if (std::find(child_keys.begin(), child_keys.end(), key) != child_keys.end()) {
+						common.push_back(key);
+					}
+				}
+				keys = std::move(common);
+			}
+			return found;
+		}
+		case TableFilterType::OPTIONAL_FILTER: {
+			auto &child = filter.Cast<OptionalFilter>().child_filter;
+			return child && CollectLookupKeys(*child, keys);
+		}
+		default:
+			return false;
+		}
+	}
+
+	//! Point ranges for the keys a filter on the leading sort key looks up, in key order, so each key is
+	//! merged on its own and the batch index returns them sorted. Empty when the scan is no lookup.
+	static vector<KeyRange> LookupKeyRanges(const OrderedReadFunctionData &bindData,
+											const OrderedReadGlobalState &glob_state) {
+		vector<KeyRange> ranges;
+		if (!glob_state.filters || bindData.sortKey[0].descending || bindData.sortKey[0].nulls_first) {
+			// point ranges are laid out in ascending key order with NULLs last
+			return ranges;
+		}
+		const auto entry = glob_state.filters->filters.find(glob_state.keyColumn);
+		vector<Value> keys;
+		if (entry == glob_state.filters->filters.end() || !CollectLookupKeys(*entry->second, keys) ||
+			keys.empty() || keys.size() > MAX_LOOKUP_KEYS) {
+			return ranges;
+		}
+		const auto &type = glob_state.scanTypes[glob_state.keyColumn];
+		vector<Value> lookup;
+		for (auto &key : keys) {
+			Value cast_key;
+			string error;
+			if (!key.DefaultTryCastAs(type, cast_key, &error)) {
+				return ranges;
+			}
+			if (!cast_key.IsNull()) {
+				// NULL never compares equal
+				lookup.push_back(std::move(cast_key));
+			}
+		}
+		if (lookup.empty()) {
+			return ranges;
+		}
+		std::sort(lookup.begin(), lookup.end());
+		lookup.erase(std::unique(lookup.begin(), lookup.end()), lookup.end());
+		for (auto &key : lookup) {
+			KeyRange range;
+			range.lo = key;
+			range.hi = key;
+			range.hi_inclusive = true;
+			ranges.push_back(std::move(range));
+		}
+		return ranges;
+	}
+
+	static unique_ptr<GlobalTableFunctionState> ParquetScanInitGlobal(ClientContext &context,
+																	   TableFunctionInitInput &input) {
 		const auto &bindData = input.bind_data->Cast<OrderedReadFunctionData>();
+		auto res = make_uniq<OrderedReadGlobalState>();
+		for (const auto column_id : input.column_ids) {
+			if (IsRowIdColumnId(column_id)) {
+				res->scanColumns.push_back(DConstants::INVALID_INDEX);
+				res->scanTypes.push_back(LogicalType::ROW_TYPE);
+				continue;
+			}
+			res->scanColumns.push_back(column_id);
+			res->scanTypes.push_back(bindData.returnTypes[column_id]);
+		}
+		for (auto &key : bindData.sortKey) {
+			auto scan_it = std::find(res->scanColumns.begin(), res->scanColumns.end(), key.globalIdx);
+			if (scan_it == res->scanColumns.end()) {
+				// the merge always needs the sort key, read it behind the projected columns
+				res->scanColumns.push_back(key.globalIdx);
+				res->scanTypes.push_back(bindData.returnTypes[key.globalIdx]);
+				scan_it = res->scanColumns.end() - 1;
+			}
+			res->keyColumns.push_back(scan_it - res->scanColumns.begin());
+		}
+		res->keyColumn = res->keyColumns[0];
+		if (bindData.engineColumnIdx != DConstants::INVALID_INDEX) {
+			auto scan_it = std::find(res->scanColumns.begin(), res->scanColumns.end(), bindData.engineColumnIdx);
+			if (scan_it == res->scanColumns.end()) {
+				res->scanColumns.push_back(bindData.engineColumnIdx);
+				res->scanTypes.push_back(bindData.returnTypes[bindData.engineColumnIdx]);
+				scan_it = res->scanColumns.end() - 1;
+			}
+			res->engineColumn = scan_it - res->scanColumns.begin();
+		}
+		if (bindData.engine == MergeEngine::SUMMING) {
+			// groups summing to zero are dropped, so every summed column is read even when it is not projected
+			for (idx_t col = 0; col < bindData.returnTypes.size(); col++) {
+				if (bindData.summableColumns[col] &&
+					std::find(res->scanColumns.begin(), res->scanColumns.end(), col) == res->scanColumns.end()) {
+					res->scanColumns.push_back(col);
+					res->scanTypes.push_back(bindData.returnTypes[col]);
+				}
+			}
+			for (idx_t col = 0; col < res->scanColumns.size(); col++) {
+				const bool key = std::find(res->keyColumns.begin(), res->keyColumns.end(), col) != res->keyColumns.end();
+				if (!key && res->scanColumns[col] != DConstants::INVALID_INDEX &&
+					bindData.summableColumns[res->scanColumns[col]]) {
+					res->sumColumns.push_back(col);
+				}
+			}
+		}
+		if (input.filters && !input.filters->filters.empty()) {
+			if (bindData.engine == MergeEngine::NONE) {
+				res->filters = input.filters;
+			} else {
+				for (auto &entry : input.filters->filters) {
+					const bool key = std::find(res->keyColumns.begin(), res->keyColumns.end(), entry.first) !=
+									 res->keyColumns.end();
+					auto &target = key ? res->keyFilters : res->postFilters;
+					target.filters[entry.first] = entry.second->Copy();
+				}
+				if (!res->keyFilters.filters.empty()) {
+					res->filters = &res->keyFilters;
+				}
+			}
+		}
+		res->ranges = LookupKeyRanges(bindData, *res);
+		if (res->ranges.empty()) {
+			res->ranges = PartitionKeyRanges(bindData, TaskScheduler::GetScheduler(context).NumberOfThreads());
+		}
+		res->lateMaterialization = bindData.lateMaterialization;
+		res->rowNumberColumn = res->scanColumns.size();
+		if (res->lateMaterialization) {
+			for (idx_t col = 0; col < input.column_ids.size(); col++) {
+				(res->IsMergedColumn(col) ? res->mergedColumns : res->payloadColumns).push_back(col);
+			}
+		}
+		return std::move(res);
+	}
+
+	//! Chunks to decode ahead for every input of a run: the configured depth, lowered so that the chunks of all
+	//! inputs fit the prefetch memory. Only the fixed-width part of strings is accounted for.
+	static idx_t PrefetchDepth(const PrefetchSettings &settings, const vector<LogicalType> &types, idx_t inputs) {
+		if (settings.depth == 0) {
+			return 0;
+		}
+		idx_t row_width = 0;
+		for (auto &type : types) {
+			row_width += GetTypeIdSize(type.InternalType());
+		}
+		const auto chunk_bytes = MaxValue<idx_t>(row_width * STANDARD_VECTOR_SIZE * MaxValue<idx_t>(inputs, 1), 1);
+		return MinValue<idx_t>(settings.depth, settings.memory / chunk_bytes);
+	}
+
+	//! Drops the row groups of a point lookup whose key column index or bloom filter rules out the key. The file
+	//! is only opened for them when the footer references either, indexes keeps it open for the next keys.
+	static vector<idx_t> PruneLookupRowGroups(ClientContext &context, const string &path, const ParquetReader &reader,
+											  idx_t file_col, const LogicalType &type, const Value &key,
+											  const vector<idx_t> &rgs, unique_ptr<ParquetIndexReader> &indexes) {
+		const auto &row_groups = reader.metadata->metadata->row_groups;
+		const auto &schema_ele = *GetLeafSchema(reader)[file_col];
+		vector<idx_t> remaining;
+		for (const auto rg : rgs) {
+			if (file_col >= row_groups[rg].columns.size()) {
+				remaining.push_back(rg);
+				continue;
+			}
+			const auto &chunk = row_groups[rg].columns[file_col];
+			const bool indexed = chunk.__isset.column_index_offset ||
+								 (chunk.__isset.meta_data && chunk.meta_data.__isset.bloom_filter_offset);
+			if (indexed && !indexes) {
+				indexes = make_uniq<ParquetIndexReader>(context, path);
+			}
+			if (!indexed || !indexes->ExcludesKey(chunk, schema_ele, type, key)) {
+				remaining.push_back(rg);
+			}
+		}
+		return remaining;
+	}
+
+	//! Opens the files of a run with row groups overlapping the key range and builds the merge heap over them.
+	//! Row groups whose statistics rule out a pushed down filter are skipped, and only the scanned columns
+	//! are decoded.
+	static void OpenRun(ClientContext &context, const OrderedReadFunctionData &bindData,
+						const OrderedReadGlobalState &glob_state, const KeyRange &range, const vector<idx_t> &run,
+						OrderedReadLocalState &loc_state) {
+		const auto init_start = ScanStats::Now();
+		const auto decoded_before = loc_state.stats.Get(ScanCounter::DECODE_NANOS);
+		loc_state.sets.clear();
 		ParquetOptions po;
 		po.binary_as_string = true;
-		for (int i = 0; i < bindData.files.size(); i++) {
+		// set chunks share the output layout, so merged runs can be copied column by column
+		auto chunkTypes = glob_state.scanTypes;
+		if (glob_state.lateMaterialization) {
+			chunkTypes.push_back(LogicalType::BIGINT);
+		}
+		const auto prefetchDepth = PrefetchDepth(loc_state.prefetchSettings, chunkTypes, run.size());
+		for (const auto i : run) {
+			const auto &bindSet = *bindData.sets[i];
+			vector<idx_t> rgs;
+			for (idx_t rg = 0; rg < bindSet.rowGroupKeys.size(); rg++) {
+				if (RowGroupOverlapsRange(bindSet.rowGroupKeys[rg], range)) {
+					rgs.push_back(rg);
+				}
+			}
+			if (rgs.empty()) {
+				continue;
+			}
 			auto set = make_uniq<ReaderSet>();
-			set->reader = make_uniq<ParquetReader>(context.client, bindData.files[i], po, nullptr);
+			set->fileIdx = i;
+			po.file_row_number = glob_state.lateMaterialization;
+			set->reader = OpenCachedParquetReader(context, bindData.files[i], po);
+			loc_state.stats.Add(ScanCounter::READERS_OPENED);
 			set->scanState = make_uniq<ParquetReaderScanState>();
-			int j = 0;
-			for (auto &el : set->reader->metadata->metadata->schema) {
-				if (el.num_children != 0) {
+			// map every scanned column to the file column holding it
+			vector<idx_t> fileColumns;
+			for (idx_t col = 0; col < glob_state.scanColumns.size(); col++) {
+				const auto global_idx = glob_state.scanColumns[col];
+				const auto file_it = std::find(bindSet.columnMap.begin(), bindSet.columnMap.end(), global_idx);
+				if (global_idx == DConstants::INVALID_INDEX || file_it == bindSet.columnMap.end()) {
+					set->missingColumns.push_back(col);
+					fileColumns.push_back(DConstants::INVALID_INDEX);
+					continue;
+				}
+				fileColumns.push_back(file_it - bindSet.columnMap.begin());
+				if (glob_state.lateMaterialization && !glob_state.IsMergedColumn(col)) {
+					// fetched after the merge for the emitted rows only
+					set->missingColumns.push_back(col);
+					continue;
+				}
+				set->reader->reader_data.column_ids.push_back(fileColumns.back());
+				set->reader->reader_data.column_mapping.push_back(col);
+			}
+			if (glob_state.lateMaterialization) {
+				set->reader->reader_data.column_ids.push_back(set->reader->file_row_number_idx);
+				set->reader->reader_data.column_mapping.push_back(glob_state.rowNumberColumn);
+			}
+			if (glob_state.filters) {
+				const auto &row_groups = set->reader->metadata->metadata->row_groups;
+				const auto leaves = GetLeafSchema(*set->reader);
+				vector<idx_t> remaining;
+				for (const auto rg : rgs) {
+					bool excluded = false;
+					for (auto &entry : glob_state.filters->filters) {
+						const auto file_col = fileColumns[entry.first];
+						if (file_col == DConstants::INVALID_INDEX) {
+							continue;
+						}
+						const auto &type = glob_state.scanTypes[entry.first];
+						if (FilterExcludesRange(*entry.second, type,
+												ReadColumnChunkRange(row_groups[rg], file_col, *leaves[file_col], type))) {
+							excluded = true;
+							break;
+						}
+					}
+					if (!excluded) {
+						remaining.push_back(rg);
+					}
+				}
+				loc_state.stats.Add(ScanCounter::ROW_GROUPS_PRUNED, rgs.size() - remaining.size());
+				rgs = std::move(remaining);
+				if (rgs.empty()) {
 					continue;
 				}
-				set->reader->reader_data.column_ids.push_back(j);
-				j++;
 			}
-			set->columnMap = bindData.sets[i]->columnMap;
-			set->reader->reader_data.column_mapping = set->columnMap;
-			vector<idx_t> rgs(set->reader->metadata->metadata->row_groups.size(), 0);
-			for (idx_t i = 0; i < rgs.size(); i++) {
-				rgs[i] = i;
+			if (range.hi_inclusive) {
+				// a point lookup: row groups whose footer range spans the key may still lack it
+				auto remaining = PruneLookupRowGroups(context, bindData.files[i], *set->reader, bindSet.orderByColumn,
+													  glob_state.scanTypes[glob_state.keyColumn], range.lo, rgs,
+													  loc_state.indexReaders[i]);
+				loc_state.stats.Add(ScanCounter::ROW_GROUPS_PRUNED, rgs.size() - remaining.size());
+				rgs = std::move(remaining);
+				if (rgs.empty()) {
+					continue;
+				}
 			}
-			set->reader->InitializeScan(context.client, *set->scanState, rgs);
+			set->columnMap = bindSet.columnMap;
+			set->reader->InitializeScan(context, *set->scanState, rgs);
+			loc_state.stats.Add(ScanCounter::ROW_GROUPS_SCANNED, rgs.size());
 			set->chunk = make_uniq<DataChunk>();
 
-			set->orderByIdx = bindData.sets[i]->orderByIdx;
+			set->orderByIdx = glob_state.keyColumn;
 			set->result_idx = 0;
-			auto ltypes = vector<LogicalType>();
-			for (const auto idx : set->columnMap) {
-				ltypes.push_back(bindData.returnTypes[idx]);
+			set->chunk->Initialize(context, chunkTypes);
+			if (prefetchDepth > 0) {
+				set->StartPrefetch(Allocator::Get(context), prefetchDepth, *loc_state.prefetchPool);
+			}
+			loc_state.sets.push_back(std::move(set));
+		}
+		// with prefetching the first chunks of all files are decoded in parallel
+		for (auto &set : loc_state.sets) {
+			loc_state.Refill(*set);
+		}
+		loc_state.BuildHeap();
+		// the first chunk of every set was decoded meanwhile, that time counts as decoding
+		const auto decoded = loc_state.stats.Get(ScanCounter::DECODE_NANOS) - decoded_before;
+		const auto elapsed = ScanStats::Now() - init_start;
+		loc_state.stats.Add(ScanCounter::INIT_NANOS, elapsed > decoded ? elapsed - decoded : 0);
+	}
+
+	//! Opens the next file run with rows in the current key range, returns false once every run was merged
+	static bool OpenNextRun(ClientContext &context, const OrderedReadFunctionData &bindData,
+							const OrderedReadGlobalState &glob_state, OrderedReadLocalState &loc_state) {
+		const auto &range = glob_state.ranges[loc_state.range_idx];
+		while (loc_state.nextRun < bindData.fileRuns.size()) {
+			if (RunFollowsRange(bindData.runKeys[loc_state.nextRun], range)) {
+				loc_state.nextRun = DConstants::INVALID_INDEX;
+				return false;
+			}
+			OpenRun(context, bindData, glob_state, range, bindData.fileRuns[loc_state.nextRun++], loc_state);
+			if (!loc_state.heap.empty()) {
+				return true;
 			}
-			set->chunk->Initialize(context.client, ltypes);
-			set->reader->Scan(*set->scanState, *set->chunk);
-			res->sets.push_back(std::move(set));
 		}
-		res->RecalculateWinnerGroup();
+		return false;
+	}
+
+	//! Starts merging a key range: its file runs are opened one after another, so a thread holds the readers
+	//! of one run at a time
+	static void InitializeRange(ClientContext &context, const OrderedReadFunctionData &bindData,
+								const OrderedReadGlobalState &glob_state, OrderedReadLocalState &loc_state) {
+		const auto &range = glob_state.ranges[loc_state.range_idx];
+		loc_state.SetBounds(range);
+		loc_state.range_emitted = 0;
+		// runs are laid out in key order: skip the ones whose keys all sort before the range, which leaves a
+		// point lookup with the few runs around its key. NULL keys belong to every range without an upper bound.
+		const auto &runKeys = bindData.runKeys;
+		loc_state.nextRun = 0;
+		if (!range.lo.IsNull()) {
+			loc_state.nextRun = std::partition_point(runKeys.begin(), runKeys.end(),
+													 [&](const RowGroupKeyRange &run) {
+														 return run.has_stats && !run.may_have_nulls &&
+																!run.max.IsNull() && run.max < range.lo;
+													 }) -
+								runKeys.begin();
+		}
+		OpenNextRun(context, bindData, glob_state, loc_state);
+	}
+
+	static unique_ptr<LocalTableFunctionState>
+	ParquetScanInitLocal(ExecutionContext &context, TableFunctionInitInput &input, GlobalTableFunctionState *gstate_p) {
+		auto res = make_uniq<OrderedReadLocalState>();
+		const auto &bindData = input.bind_data->Cast<OrderedReadFunctionData>();
+		const auto &keyType = bindData.returnTypes[bindData.sets[0]->orderByIdx];
+		res->compare = GetOrderKeyComparator(keyType);
+		res->bounds.Initialize(context.client, {keyType});
+		auto &glob_state = gstate_p->Cast<OrderedReadGlobalState>();
+		vector<LogicalType> keyTypes;
+		for (auto &key : bindData.sortKey) {
+			keyTypes.push_back(bindData.returnTypes[key.globalIdx]);
+		}
+		res->layout.Initialize(bindData.sortKey, glob_state.keyColumns, keyTypes);
+		res->filters = glob_state.filters;
+		res->statsTotals = ScanStatsTotals::Get(context.client);
+		res->queryStats = bindData.queryStats;
+		res->prefetchSettings = PrefetchSettings::Get(context.client);
+		if (res->prefetchSettings.depth > 0) {
+			res->prefetchPool = PrefetchPool::Get(context.client, res->prefetchSettings);
+		}
+		if (bindData.engine != MergeEngine::NONE) {
+			res->group.Initialize(context.client, bindData.engine, glob_state);
+		}
+		if (glob_state.lateMaterialization) {
+			// the output holds the requested columns, not the order key appended behind them
+			res->staging.Initialize(context.client,
+									vector<LogicalType>(glob_state.scanTypes.begin(),
+														glob_state.scanTypes.begin() + input.column_ids.size()));
+		}
+		if (glob_state.NextRange(res->range_idx)) {
+			InitializeRange(context.client, bindData, glob_state, *res);
+		}
 		return std::move(res);
 	}
 
-	static void ParquetOrderedScanImplementation(
-		ClientContext &context, duckdb::TableFunctionInput &data_p,DataChunk &output) {
-		auto &loc_state = data_p.local_state->Cast<OrderedReadLocalState>();
-		const auto &fieldNames = data_p.bind_data->Cast<OrderedReadFunctionData>().names;
-		const auto &returnTypes = data_p.bind_data->Cast<OrderedReadFunctionData>().returnTypes;
-		bool toRecalc = false;
-		for (int i = loc_state.sets.size() - 1; i >= 0 ; i--) {
-			if (loc_state.sets[i]->result_idx >= loc_state.sets[i]->chunk->size()) {
-				auto &set = loc_state.sets[i];
-				set->chunk->Reset();
-				loc_state.sets[i]->reader->Scan(
-					*loc_state.sets[i]->scanState,
-					*loc_state.sets[i]->chunk);
-				loc_state.sets[i]->result_idx = 0;
+	//! Opens the payload reader of a file for late materialization, decoding only the output columns the merge
+	//! did not read
+	static PayloadCursor &GetPayloadCursor(ClientContext &context, const OrderedReadFunctionData &bindData,
+										   const OrderedReadGlobalState &glob_state,
+										   OrderedReadLocalState &loc_state, idx_t file_idx) {
+		auto &entry = loc_state.payload[file_idx];
+		if (entry) {
+			return *entry;
+		}
+		entry = make_uniq<PayloadCursor>();
+		ParquetOptions po;
+		po.binary_as_string = true;
+		entry->reader = OpenCachedParquetReader(context, bindData.files[file_idx], po);
+		const auto &columnMap = bindData.sets[file_idx]->columnMap;
+		for (const auto col : glob_state.payloadColumns) {
+			const auto global_idx = glob_state.scanColumns[col];
+			const auto file_it = std::find(columnMap.begin(), columnMap.end(), global_idx);
+			if (global_idx == DConstants::INVALID_INDEX || file_it == columnMap.end()) {
+				entry->missingColumns.push_back(col);
+				continue;
+			}
+			entry->reader->reader_data.column_ids.push_back(file_it - columnMap.begin());
+			entry->reader->reader_data.column_mapping.push_back(col);
+		}
+		idx_t start = 0;
+		for (auto &rg : entry->reader->metadata->metadata->row_groups) {
+			entry->rowGroupStarts.push_back(start);
+			start += rg.num_rows;
+		}
+		entry->chunk.Initialize(context, loc_state.staging.GetTypes());
+		return *entry;
+	}
 
-				if (loc_state.sets[i]->chunk->size() == 0) {
-					loc_state.RemoveSetGracefully(i);
+	//! Fetches the payload columns of the located rows. Rows are gathered file by file into the staging chunk,
+	//! the output then references the staging chunk through a selection restoring the merge order. Afterwards
+	//! the readers of files without rows left in the current run are closed.
+	static void MaterializeLocatedRows(ClientContext &context, const OrderedReadFunctionData &bindData,
+									   const OrderedReadGlobalState &glob_state, OrderedReadLocalState &loc_state,
+									   DataChunk &output, idx_t count) {
+		if (glob_state.payloadColumns.empty()) {
+			// the merge read every output column
+			output.SetCardinality(count);
+			return;
+		}
+		auto &staging = loc_state.staging;
+		staging.Reset();
+		SelectionVector output_sel(STANDARD_VECTOR_SIZE);
+		SelectionVector chunk_sel(STANDARD_VECTOR_SIZE);
+		bool done[STANDARD_VECTOR_SIZE] = {};
+		idx_t staged = 0;
+		for (idx_t first = 0; first < count; first++) {
+			if (done[first]) {
+				continue;
+			}
+			const auto file_idx = loc_state.locatorFiles[first];
+			auto &cursor = GetPayloadCursor(context, bindData, glob_state, loc_state, file_idx);
+			idx_t pending = 0;
+			auto flush = [&]() {
+				for (const auto col : glob_state.payloadColumns) {
+					VectorOperations::Copy(cursor.chunk.data[col], staging.data[col], chunk_sel, pending, 0, staged);
+				}
+				staged += pending;
+				pending = 0;
+			};
+			for (idx_t i = first; i < count; i++) {
+				if (done[i] || loc_state.locatorFiles[i] != file_idx) {
+					continue;
+				}
+				const auto row = NumericCast<idx_t>(loc_state.locatorRows[i]);
+				if (pending > 0 && (row < cursor.chunkStart || row >= cursor.chunkStart + cursor.chunk.size())) {
+					flush();
 				}
-				toRecalc = true;
+				cursor.Seek(context, row);
+				chunk_sel.set_index(pending, row - cursor.chunkStart);
+				output_sel.set_index(i, staged + pending);
+				pending++;
+				done[i] = true;
 			}
+			flush();
 		}
-		if (loc_state.sets.empty()) {
-			return;
+		staging.SetCardinality(staged);
+		for (const auto col : glob_state.payloadColumns) {
+			output.data[col].Slice(staging.data[col], output_sel, count);
 		}
-		if (toRecalc) {
-			loc_state.RecalculateWinnerGroup();
-		}
-		int cap = 1024;
-		output.Reset();
-		output.SetCapacity(cap);
-		idx_t j = 0;
-		if (loc_state.winner_group.size() == 1) {
-			auto &set = loc_state.sets[loc_state.winner_group[0]];
-			set->chunk->Slice(set->result_idx, set->chunk->size() - set->result_idx);
-			output.Append(*set->chunk, true);
-			output.SetCardinality(set->chunk->size());
-			set->result_idx = set->chunk->size();
-			return;
+		output.SetCardinality(count);
+		for (auto entry = loc_state.payload.begin(); entry != loc_state.payload.end();) {
+			bool live = false;
+			for (const auto set_idx : loc_state.heap) {
+				live = live || loc_state.sets[set_idx]->fileIdx == entry->first;
+			}
+			entry = live ? std::next(entry) : loc_state.payload.erase(entry);
+		}
+	}
+
+	//! Merges the current key range folding every key group into at most one row. An output chunk only holds
+	//! rows of one range, which is its batch index. Groups never cross ranges, as ranges are cut between values
+	//! of the leading sort key.
+	static idx_t MergeGroups(ClientContext &context, const OrderedReadFunctionData &bindData,
+							 OrderedReadGlobalState &glob_state, OrderedReadLocalState &loc_state, DataChunk &output) {
+		auto &group = loc_state.group;
+		idx_t out_idx = 0;
+		// a group may emit more than one row, stop while the output still has room for it
+		while (out_idx + group.MaxEmitRows() <= STANDARD_VECTOR_SIZE) {
+			if (loc_state.heap.empty()) {
+				if (OpenNextRun(context, bindData, glob_state, loc_state)) {
+					// keys of the next run sort after the group, it ends with the next merged row
+					continue;
+				}
+				if (group.active) {
+					// the exhausted range ends its last group
+					out_idx += group.Emit(output, out_idx);
+					continue;
+				}
+				if (out_idx > 0 || !glob_state.NextRange(loc_state.range_idx)) {
+					break;
+				}
+				InitializeRange(context, bindData, glob_state, loc_state);
+				continue;
+			}
+			auto &top = *loc_state.sets[loc_state.heap[0]];
+			const auto run_end = loc_state.RunEnd(loc_state.RunnerUp());
+			group.PrepareRun(top);
+			const auto run_start = top.result_idx;
+			auto row = run_start;
+			for (; row < run_end; row++) {
+				loc_state.comparisons += group.active;
+				if (group.active && loc_state.layout.Compare(group.head, 0, top, row) != 0) {
+					if (out_idx + group.MaxEmitRows() > STANDARD_VECTOR_SIZE) {
+						break;
+					}
+					out_idx += group.Emit(output, out_idx);
+				}
+				group.Add(loc_state.layout, top, row);
+			}
+			loc_state.stats.Add(ScanCounter::ROWS_MERGED, row - run_start);
+			loc_state.stats.Add(ScanCounter::COPIED_RUNS);
+			top.result_idx = row;
+			loc_state.FixTop();
 		}
-		while(true) {
-			auto winnerSet = &loc_state.sets[loc_state.winner_group[0]];
-			Value winner_val = (*winnerSet)->chunk->GetValue(
-									(*winnerSet)->orderByIdx,
-									(*winnerSet)->result_idx
-									);
-			for (int k = 1; k < loc_state.winner_group.size(); k++) {
-				const auto i = loc_state.winner_group[k];
-				const auto &set = loc_state.sets[i];
-				const Value &val = set->chunk->GetValue(set->orderByIdx, set->result_idx);
-				if (val < winner_val) {
-					winnerSet = &loc_state.sets[i];
-					winner_val = (*winnerSet)->chunk->GetValue(set->orderByIdx, set->result_idx);
-				}
-			}
-			for (int i = 0; i < fieldNames.size(); i++) {
-				const auto &val = (*winnerSet)->chunk->GetValue(i,(*winnerSet)->result_idx);
-				output.SetValue(i, j, val);
-			}
-			j++;
-			(*winnerSet)->result_idx++;
-			if ((*winnerSet)->result_idx >= (*winnerSet)->chunk->size() || j >= 2048) {
-				output.SetCardinality(j);
+		return out_idx;
+	}
+
+	//! Scan of a merge engine: the filters on non-key columns and the limit apply to the folded rows
+	static void MergeEngineScan(ClientContext &context, const OrderedReadFunctionData &bindData,
+								OrderedReadGlobalState &glob_state, OrderedReadLocalState &loc_state,
+								DataChunk &output) {
+		while (true) {
+			const auto count = MergeGroups(context, bindData, glob_state, loc_state, output);
+			output.SetCardinality(count);
+			if (count == 0) {
+				return;
+			}
+			if (!glob_state.postFilters.filters.empty()) {
+				SelectionVector sel(STANDARD_VECTOR_SIZE);
+				for (idx_t row = 0; row < count; row++) {
+					sel.set_index(row, row);
+				}
+				idx_t selected = count;
+				for (auto &entry : glob_state.postFilters.filters) {
+					selected = SelectTableFilter(output.data[entry.first], count, *entry.second, sel, selected);
+				}
+				if (selected < count) {
+					output.Slice(sel, selected);
+				}
+			}
+			if (bindData.limit != DConstants::INVALID_INDEX) {
+				const auto remaining = bindData.limit - loc_state.range_emitted;
+				if (output.size() >= remaining) {
+					// the range produced all rows the limit can use, stop merging it
+					output.SetCardinality(remaining);
+					loc_state.EndRange();
+					loc_state.group.active = false;
+				}
+				loc_state.range_emitted += output.size();
+			}
+			if (output.size() > 0) {
 				return;
 			}
-			if (j >= cap) {
-				cap *= 2;
-				output.SetCapacity(cap);
+			// every folded row was filtered out, an empty chunk would end the scan
+			output.Reset();
+		}
+	}
+
+	//! Adds the duration of a scan call to MERGE_NANOS, minus the decoding and range setup it triggered
+	struct MergeTimer {
+		explicit MergeTimer(ScanStats &stats_p) : stats(stats_p), start(ScanStats::Now()), excluded(Excluded()) {
+		}
+		~MergeTimer() {
+			const auto elapsed = ScanStats::Now() - start;
+			const auto other = Excluded() - excluded;
+			stats.Add(ScanCounter::MERGE_NANOS, elapsed > other ? elapsed - other : 0);
+		}
+		idx_t Excluded() const {
+			return stats.Get(ScanCounter::DECODE_NANOS) + stats.Get(ScanCounter::INIT_NANOS);
+		}
+
+		ScanStats &stats;
+		uint64_t start;
+		idx_t excluded;
+	};
+
+	static void ParquetOrderedScanImplementation(
+		ClientContext &context, duckdb::TableFunctionInput &data_p,DataChunk &output) {
+		auto &loc_state = data_p.local_state->Cast<OrderedReadLocalState>();
+		auto &glob_state = data_p.global_state->Cast<OrderedReadGlobalState>();
+		const auto &bindData = data_p.bind_data->Cast<OrderedReadFunctionData>();
+		MergeTimer timer(loc_state.stats);
+		if (bindData.engine != MergeEngine::NONE) {
+			MergeEngineScan(context, bindData, glob_state, loc_state, output);
+			return;
+		}
+		if (loc_state.refill_top) {
+			loc_state.refill_top = false;
+			loc_state.FixTop();
+		}
+		while (true) {
+			while (loc_state.heap.empty() && !OpenNextRun(context, bindData, glob_state, loc_state)) {
+				if (!glob_state.NextRange(loc_state.range_idx)) {
+					return;
+				}
+				InitializeRange(context, bindData, glob_state, loc_state);
+			}
+			idx_t out_idx = 0;
+			while (out_idx < STANDARD_VECTOR_SIZE &&
+				   (!loc_state.heap.empty() || OpenNextRun(context, bindData, glob_state, loc_state))) {
+				auto &top = *loc_state.sets[loc_state.heap[0]];
+				const auto run_start = top.result_idx;
+				auto run_end = MinValue<idx_t>(loc_state.RunEnd(loc_state.RunnerUp()),
+											   run_start + STANDARD_VECTOR_SIZE - out_idx);
+				if (bindData.limit != DConstants::INVALID_INDEX) {
+					run_end = MinValue<idx_t>(run_end, run_start + bindData.limit - loc_state.range_emitted);
+				}
+				loc_state.range_emitted += run_end - run_start;
+				loc_state.stats.Add(ScanCounter::ROWS_MERGED, run_end - run_start);
+				const bool zero_copy = !glob_state.lateMaterialization && out_idx == 0 && run_end == top.end_idx;
+				loc_state.stats.Add(zero_copy ? ScanCounter::ZERO_COPY_RUNS : ScanCounter::COPIED_RUNS);
+				if (glob_state.lateMaterialization) {
+					const auto row_numbers = FlatVector::GetData<int64_t>(top.chunk->data[glob_state.rowNumberColumn]);
+					for (const auto col : glob_state.mergedColumns) {
+						VectorOperations::Copy(top.chunk->data[col], output.data[col], run_end, run_start, out_idx);
+					}
+					for (idx_t row = run_start; row < run_end; row++) {
+						loc_state.locatorFiles[out_idx] = top.fileIdx;
+						loc_state.locatorRows[out_idx] = row_numbers[row];
+						out_idx++;
+					}
+				} else if (zero_copy) {
+					// the rest of the top chunk sorts before every other set: reference it instead of copying
+					for (idx_t col = 0; col < output.ColumnCount(); col++) {
+						output.data[col].Slice(top.chunk->data[col], run_start, run_end);
+					}
+					output.SetCardinality(run_end - run_start);
+					top.result_idx = run_end;
+					if (loc_state.range_emitted == bindData.limit) {
+						// the sliced chunk stays alive through the output, the readers are no longer needed
+						loc_state.EndRange();
+					} else {
+						loc_state.refill_top = true;
+					}
+					return;
+				} else {
+					for (idx_t col = 0; col < output.ColumnCount(); col++) {
+						VectorOperations::Copy(top.chunk->data[col], output.data[col], run_end, run_start, out_idx);
+					}
+					out_idx += run_end - run_start;
+				}
+				top.result_idx = run_end;
+				if (loc_state.range_emitted == bindData.limit) {
+					// the range produced all rows the limit can use, stop merging it
+					loc_state.EndRange();
+					break;
+				}
+				loc_state.FixTop();
+			}
+			if (out_idx == 0) {
+				// the limit ended the range without a row, an empty chunk would end the scan of this thread
+				continue;
+			}
+			if (glob_state.lateMaterialization) {
+				MaterializeLocatedRows(context, bindData, glob_state, loc_state, output, out_idx);
+				return;
 			}
+			output.SetCardinality(out_idx);
+			return;
 		}
 	}
 
+	static idx_t ParquetOrderedScanGetBatchIndex(ClientContext &context, const FunctionData *bind_data_p,
+												 LocalTableFunctionState *local_state,
+												 GlobalTableFunctionState *global_state) {
+		return local_state->Cast<OrderedReadLocalState>().range_idx;
+	}
+
+	static string ParquetOrderedScanToString(const FunctionData *bind_data_p) {
+		const auto &bindData = bind_data_p->Cast<OrderedReadFunctionData>();
+		idx_t row_groups = 0;
+		for (auto &set : bindData.sets) {
+			row_groups += set->rowGroupKeys.size();
+		}
+		auto result = StringUtil::Format(
+			"READ_PARQUET_MERGETREE\nSort Key: %s\nFiles: %llu\nFile Runs: %llu\nRow Groups: %llu\nBind: %.3f ms",
+			bindData.orderBy, bindData.files.size(), bindData.fileRuns.size(), row_groups, bindData.bindNanos / 1e6);
+		const auto stats = bindData.queryStats->Snapshot();
+		if (stats.Get(ScanCounter::READERS_OPENED) > 0) {
+			// the scan ran already, as in EXPLAIN ANALYZE
+			result += StringUtil::Format(
+				"\nReaders Opened: %llu\nRow Groups Scanned: %llu\nRow Groups Pruned: %llu\nRows Merged: %llu"
+				"\nZero Copy Runs: %llu\nCopied Runs: %llu\nComparisons: %llu\nInit: %.3f ms\nDecode: %.3f ms"
+				"\nMerge: %.3f ms",
+				stats.Get(ScanCounter::READERS_OPENED), stats.Get(ScanCounter::ROW_GROUPS_SCANNED),
+				stats.Get(ScanCounter::ROW_GROUPS_PRUNED), stats.Get(ScanCounter::ROWS_MERGED),
+				stats.Get(ScanCounter::ZERO_COPY_RUNS), stats.Get(ScanCounter::COPIED_RUNS),
+				stats.Get(ScanCounter::COMPARISONS), stats.Get(ScanCounter::INIT_NANOS) / 1e6,
+				stats.Get(ScanCounter::DECODE_NANOS) / 1e6, stats.Get(ScanCounter::MERGE_NANOS) / 1e6);
+		}
+		return result;
+	}
+
+	//! read_parquet_mergetree(files, order_by [, late_materialization, limit, engine, version, sign]). The limit
+	//! parameter caps the rows of every key range the scan is split into, not of the whole query, it only lets the
+	//! ranges stop decoding early below a LIMIT.
 	TableFunction ReadParquetOrderedFunction() {
 		TableFunction tf = duckdb::TableFunction(
 			"read_parquet_mergetree",
 			{LogicalType::LIST(LogicalType::VARCHAR), LogicalType::VARCHAR},
 			ParquetOrderedScanImplementation,
 			OrderedParquetScanBind,
-			nullptr,
+			ParquetScanInitGlobal,
 			ParquetScanInitLocal
 			);
+		tf.get_batch_index = ParquetOrderedScanGetBatchIndex;
+		tf.to_string = ParquetOrderedScanToString;
+		tf.projection_pushdown = true;
+		tf.filter_pushdown = true;
+		tf.named_parameters["late_materialization"] = LogicalType::BOOLEAN;
+		tf.named_parameters["limit"] = LogicalType::UBIGINT;
+		tf.named_parameters["engine"] = LogicalType::VARCHAR;
+		tf.named_parameters["version"] = LogicalType::VARCHAR;
+		tf.named_parameters["sign"] = LogicalType::VARCHAR;
+		return tf;
+	}
+
+	//! Row group size of the compacted files, DuckDB's default for Parquet
+	static constexpr idx_t COMPACT_ROW_GROUP_SIZE = 122880;
+
+	//! Output files of mergetree_compact: each holds one key range of the merge, so the files are sorted and
+	//! their key ranges do not overlap
+	struct CompactFunctionData : TableFunctionData {
+		//! Ordered scan of the input files, run once per output file with the key filter of its range
+		unique_ptr<OrderedReadFunctionData> scan;
+		//! Ranges of the leading sort key in ascending order, the files take them in the order of the key
+		vector<KeyRange> ranges;
+		//! Whether the leading sort key may hold NULLs, they belong to the first or the last file
+		bool keyHasNulls = true;
+		string target;
+		idx_t rowGroupSize = COMPACT_ROW_GROUP_SIZE;
+		//! Parquet writer of COPY TO, bound once for the columns of the scan
+		CopyFunction copy = CopyFunction("parquet");
+		unique_ptr<FunctionData> copyBind;
+
+		//! Key range of the output file, reversed for a descending key
+		const KeyRange &FileRange(idx_t file_idx) const {
+			return scan->sortKey[0].descending ? ranges[ranges.size() - 1 - file_idx] : ranges[file_idx];
+		}
+		//! Whether the NULL keys belong to the output file
+		bool FileHasNulls(idx_t file_idx) const {
+			return keyHasNulls && (scan->sortKey[0].nulls_first ? file_idx == 0 : file_idx + 1 == ranges.size());
+		}
+	};
+
+	struct CompactGlobalState : GlobalTableFunctionState {
+		idx_t next_file = 0;
+	};
+
+	static unique_ptr<FunctionData> MergeTreeCompactBind(ClientContext &context, TableFunctionBindInput &input,
+														 vector<LogicalType> &return_types, vector<string> &names) {
+		auto res = make_uniq<CompactFunctionData>();
+		res->scan = make_uniq<OrderedReadFunctionData>();
+		vector<LogicalType> scan_types;
+		vector<string> scan_names;
+		BindOrderedScan(context, input.inputs[0], input.inputs[1].GetValue<string>(), input.named_parameters,
+						*res->scan, scan_types, scan_names);
+		res->target = input.inputs[2].GetValue<string>();
+		const auto rows_per_file = input.inputs[3].GetValue<idx_t>();
+		if (rows_per_file == 0) {
+			throw BinderException("mergetree_compact: rows_per_file must be positive");
+		}
+		auto entry = input.named_parameters.find("row_group_size");
+		if (entry != input.named_parameters.end()) {
+			res->rowGroupSize = entry->second.GetValue<idx_t>();
+			if (res->rowGroupSize == 0) {
+				throw BinderException("mergetree_compact: row_group_size must be positive");
+			}
+		}
+		idx_t total_rows = 0;
+		res->keyHasNulls = false;
+		for (auto &set : res->scan->sets) {
+			for (auto &rg : set->rowGroupKeys) {
+				total_rows += rg.rows;
+				res->keyHasNulls = res->keyHasNulls || rg.may_have_nulls;
+			}
+		}
+		res->ranges =
+			CutKeyRanges(*res->scan, MaxValue<idx_t>((total_rows + rows_per_file - 1) / rows_per_file, 1));
+		res->copy = Catalog::GetEntry<CopyFunctionCatalogEntry>(context, INVALID_CATALOG, DEFAULT_SCHEMA, "parquet")
+						.function;
+		CopyInfo info;
+		info.options["row_group_size"] = {Value::UBIGINT(res->rowGroupSize)};
+		CopyFunctionBindInput copy_input(info);
+		res->copyBind = res->copy.copy_to_bind(context, copy_input, scan_names, scan_types);
+		return_types = {LogicalType::VARCHAR, LogicalType::BIGINT};
+		names = {"file", "rows"};
+		return std::move(res);
+	}
+
+	static unique_ptr<GlobalTableFunctionState> MergeTreeCompactInitGlobal(ClientContext &context,
+																		   TableFunctionInitInput &input) {
+		return make_uniq<CompactGlobalState>();
+	}
+
+	//! Filter on the leading sort key selecting the rows of one output file: the keys of its range, and the
+	//! NULL keys when they belong to it. Returns nullptr for a single file, which takes every row.
+	static unique_ptr<TableFilter> CompactKeyFilter(const KeyRange &range, bool with_nulls) {
+		if (range.lo.IsNull() && range.hi.IsNull()) {
+			return nullptr;
+		}
+		auto bounds = make_uniq<ConjunctionAndFilter>();
+		if (!range.lo.IsNull()) {
+			bounds->child_filters.push_back(
+				make_uniq<ConstantFilter>(ExpressionType::COMPARE_GREATERTHANOREQUALTO, range.lo));
+		}
+		if (!range.hi.IsNull()) {
+			bounds->child_filters.push_back(make_uniq<ConstantFilter>(ExpressionType::COMPARE_LESSTHAN, range.hi));
+		}
+		if (!with_nulls) {
+			return std::move(bounds);
+		}
+		auto res = make_uniq<ConjunctionOrFilter>();
+		res->child_filters.push_back(std::move(bounds));
+		res->child_filters.push_back(make_uniq<IsNullFilter>());
+		return std::move(res);
+	}
+
+	//! Streams the merge of one output file into the Parquet writer and returns the rows written. The ordered
+	//! scan runs on this thread as part of the calling query, its key filter also prunes the row groups of the
+	//! other files. The writer keeps the order of the chunks it is given and records min/max statistics for
+	//! every column chunk, memory stays bounded by the merge inputs and the row group being written.
+	static idx_t WriteCompactFile(ClientContext &context, const CompactFunctionData &bindData, idx_t file_idx,
+								  const string &path) {
+		auto &scan = *bindData.scan;
+		TableFilterSet filters;
+		auto key_filter = CompactKeyFilter(bindData.FileRange(file_idx), bindData.FileHasNulls(file_idx));
+		if (key_filter) {
+			filters.filters[scan.sortKey[0].globalIdx] = std::move(key_filter);
+		}
+		vector<column_t> column_ids;
+		for (idx_t col = 0; col < scan.returnTypes.size(); col++) {
+			column_ids.push_back(col);
+		}
+		vector<idx_t> projection_ids;
+		TableFunctionInitInput init_input(&scan, column_ids, projection_ids, &filters);
+		ThreadContext thread(context);
+		ExecutionContext exec(context, thread, nullptr);
+		auto scan_global = ParquetScanInitGlobal(context, init_input);
+		auto scan_local = ParquetScanInitLocal(exec, init_input, scan_global.get());
+		auto &copy_bind = *bindData.copyBind;
+		auto copy_global = bindData.copy.copy_to_initialize_global(context, copy_bind, path);
+		auto copy_local = bindData.copy.copy_to_initialize_local(exec, copy_bind);
+		DataChunk chunk;
+		chunk.Initialize(context, scan.returnTypes);
+		idx_t rows = 0;
+		while (true) {
+			chunk.Reset();
+			TableFunctionInput scan_input(&scan, scan_local.get(), scan_global.get());
+			ParquetOrderedScanImplementation(context, scan_input, chunk);
+			if (chunk.size() == 0) {
+				break;
+			}
+			rows += chunk.size();
+			bindData.copy.copy_to_sink(exec, copy_bind, *copy_global, *copy_local, chunk);
+		}
+		bindData.copy.copy_to_combine(exec, copy_bind, *copy_global, *copy_local);
+		bindData.copy.copy_to_finalize(context, copy_bind, *copy_global);
+		return rows;
+	}
+
+	//! Writes the compacted files, one per key range in the order of the sort key
+	static void MergeTreeCompactImplementation(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+		const auto &bindData = data_p.bind_data->Cast<CompactFunctionData>();
+		auto &state = data_p.global_state->Cast<CompactGlobalState>();
+		if (state.next_file >= bindData.ranges.size()) {
+			return;
+		}
+		auto &fs = FileSystem::GetFileSystem(context);
+		if (state.next_file == 0 && !fs.DirectoryExists(bindData.target)) {
+			fs.CreateDirectory(bindData.target);
+		}
+		idx_t count = 0;
+		while (state.next_file < bindData.ranges.size() && count < STANDARD_VECTOR_SIZE) {
+			const auto file_idx = state.next_file++;
+			const auto path = fs.JoinPath(bindData.target, StringUtil::Format("part_%05llu.parquet", file_idx));
+			const auto rows = WriteCompactFile(context, bindData, file_idx, path);
+			output.SetValue(0, count, Value(path));
+			output.SetValue(1, count, Value::BIGINT(NumericCast<int64_t>(rows)));
+			count++;
+		}
+		output.SetCardinality(count);
+	}
+
+	TableFunction MergeTreeCompactFunction() {
+		TableFunction tf = duckdb::TableFunction(
+			"mergetree_compact",
+			{LogicalType::LIST(LogicalType::VARCHAR), LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::UBIGINT},
+			MergeTreeCompactImplementation,
+			MergeTreeCompactBind,
+			MergeTreeCompactInitGlobal
+			);
+		tf.named_parameters["row_group_size"] = LogicalType::UBIGINT;
+		tf.named_parameters["engine"] = LogicalType::VARCHAR;
+		tf.named_parameters["version"] = LogicalType::VARCHAR;
+		tf.named_parameters["sign"] = LogicalType::VARCHAR;
 		return tf;
 	}
 }
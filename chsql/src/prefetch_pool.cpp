@@ -0,0 +1,89 @@
+#include "prefetch_pool.hpp"
+#include "duckdb/main/config.hpp"
+
+namespace duckdb {
+
+static constexpr const char *PREFETCH_DEPTH_SETTING = "chsql_prefetch_depth";
+static constexpr const char *PREFETCH_MEMORY_SETTING = "chsql_prefetch_memory";
+static constexpr const char *PREFETCH_THREADS_SETTING = "chsql_prefetch_threads";
+
+PrefetchSettings PrefetchSettings::Get(ClientContext &context) {
+	PrefetchSettings settings;
+	Value value;
+	if (context.TryGetCurrentSetting(PREFETCH_DEPTH_SETTING, value)) {
+		settings.depth = value.GetValue<idx_t>();
+	}
+	if (context.TryGetCurrentSetting(PREFETCH_MEMORY_SETTING, value)) {
+		settings.memory = DBConfig::ParseMemoryLimit(value.ToString());
+	}
+	if (context.TryGetCurrentSetting(PREFETCH_THREADS_SETTING, value)) {
+		settings.threads = MaxValue<idx_t>(value.GetValue<idx_t>(), 1);
+	}
+	return settings;
+}
+
+PrefetchPool::~PrefetchPool() {
+	{
+		lock_guard<mutex> guard(lock);
+		shutdown = true;
+	}
+	wakeup.notify_all();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+}
+
+shared_ptr<PrefetchPool> PrefetchPool::Get(ClientContext &context, const PrefetchSettings &settings) {
+	auto pool = ObjectCache::GetObjectCache(context).GetOrCreate<PrefetchPool>(ObjectType());
+	pool->EnsureThreads(settings.threads);
+	return pool;
+}
+
+void PrefetchPool::EnsureThreads(idx_t count) {
+	lock_guard<mutex> guard(lock);
+	// the pool only grows, lowering the setting takes effect on the next database
+	while (threads.size() < count) {
+		threads.emplace_back([this]() { Work(); });
+	}
+}
+
+void PrefetchPool::Submit(std::function<void()> job) {
+	{
+		lock_guard<mutex> guard(lock);
+		jobs.push_back(std::move(job));
+	}
+	wakeup.notify_one();
+}
+
+void PrefetchPool::Work() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<mutex> guard(lock);
+			wakeup.wait(guard, [this]() { return shutdown || !jobs.empty(); });
+			if (shutdown) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+void RegisterPrefetchSettings(DatabaseInstance &instance) {
+	auto &config = DBConfig::GetConfig(instance);
+	config.AddExtensionOption(PREFETCH_DEPTH_SETTING,
+	                          "Chunks read_parquet_mergetree decodes ahead of the merge for every input, 0 disables "
+	                          "prefetching",
+	                          LogicalType::UBIGINT, Value::UBIGINT(2));
+	config.AddExtensionOption(PREFETCH_MEMORY_SETTING,
+	                          "Memory a read_parquet_mergetree scan thread may hold in chunks decoded ahead, e.g. "
+	                          "'256MB'",
+	                          LogicalType::VARCHAR, Value("256MB"));
+	config.AddExtensionOption(PREFETCH_THREADS_SETTING,
+	                          "Threads decoding chunks ahead of read_parquet_mergetree merges, shared by all queries",
+	                          LogicalType::UBIGINT, Value::UBIGINT(4));
+}
+
+} // namespace duckdb
@@ -0,0 +1,64 @@
+#include "scan_stats.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+namespace duckdb {
+
+//! Names of the counters as reported by chsql_stats(), in ScanCounter order
+static const char *const SCAN_COUNTER_NAMES[] = {
+    "files_bound",       "bind_nanos",     "readers_opened", "init_nanos",      "row_groups_scanned",
+    "row_groups_pruned", "chunks_decoded", "decode_nanos",   "prefetch_stalls", "rows_merged",
+    "zero_copy_runs",    "copied_runs",    "comparisons",    "merge_nanos"};
+static_assert(sizeof(SCAN_COUNTER_NAMES) / sizeof(SCAN_COUNTER_NAMES[0]) == static_cast<idx_t>(ScanCounter::COUNT),
+              "every scan counter needs a name");
+
+shared_ptr<ScanStatsTotals> ScanStatsTotals::Get(ClientContext &context) {
+	return ObjectCache::GetObjectCache(context).GetOrCreate<ScanStatsTotals>(ObjectType());
+}
+
+void ScanStatsTotals::Add(const ScanStats &stats) {
+	lock_guard<mutex> guard(lock);
+	for (idx_t i = 0; i < static_cast<idx_t>(ScanCounter::COUNT); i++) {
+		totals.values[i] += stats.values[i];
+	}
+}
+
+ScanStats ScanStatsTotals::Snapshot() {
+	lock_guard<mutex> guard(lock);
+	return totals;
+}
+
+struct ScanStatsState : GlobalTableFunctionState {
+	ScanStats stats;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> ScanStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                              vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"name", "value"};
+	return_types = {LogicalType::VARCHAR, LogicalType::UBIGINT};
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> ScanStatsInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<ScanStatsState>();
+	state->stats = ScanStatsTotals::Get(context)->Snapshot();
+	return std::move(state);
+}
+
+static void ScanStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<ScanStatsState>();
+	idx_t count = 0;
+	for (; state.offset < static_cast<idx_t>(ScanCounter::COUNT); state.offset++) {
+		output.SetValue(0, count, Value(SCAN_COUNTER_NAMES[state.offset]));
+		output.SetValue(1, count, Value::UBIGINT(state.stats.values[state.offset]));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+void RegisterScanStats(DatabaseInstance &instance) {
+	TableFunction stats("chsql_stats", {}, ScanStatsFunction, ScanStatsBind, ScanStatsInit);
+	ExtensionUtil::RegisterFunction(instance, stats);
+}
+
+} // namespace duckdb
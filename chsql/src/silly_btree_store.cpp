@@ -1,85 +1,1024 @@
-#include <duckdb.hpp>
-#include <hash_map>
-#include <map>
-#include <unordered_map>
+#include "chsql_extension.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/common/types/string_heap.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 namespace duckdb {
-    struct SillyTreeKey {
-        //TODO: key-value pair using duckdb::Value
-    };
-    struct SillyTreeValue {
-        //TODO: key-value pair using duckdb::Value
-    };
-    static std::unordered_map<idx_t, std::map<SillyTreeKey, SillyTreeValue>> silly_btree_store;
-    static std::unordered_map<idx_t, unique_ptr<std::mutex>> silly_btree_store_mutex;
-    static std::mutex silly_btree_store_mutex_lock;
-
-
-
-    struct  _lock {
-        std::mutex &_m;
-        _lock(std::mutex &m) : _m(m) {
-            _m.lock();
-        }
-        ~_lock() {
-            _m.unlock();
-        }
-    };
-
-    struct AppendTreeData:FunctionData {
-        unique_ptr<FunctionData> Copy() const override {
-            throw std::runtime_error("not implemented");
-        }
-
-        bool Equals(const FunctionData &other) const override {
-            return false;
-        }
-
-        idx_t tree_id;
-        Value key;
-        Value value;
-    };
-
-    static unique_ptr<AppendTreeData> AppendTreeBind(ClientContext &context, TableFunctionBindInput &input,
-        vector<LogicalType> &return_types, vector<string> &names) {
-        auto res = make_uniq<AppendTreeData>();
-        res->tree_id = input.inputs[0].GetValue<idx_t>();
-        res->key = input.inputs[1].GetValue<Value>();
-        res->value = input.inputs[2].GetValue<Value>();
-        return_types.clear();
-        return_types.push_back(LogicalType::TINYINT);
-        names.clear();
-        names.push_back("ok");
-        return res;
-    }
-
-    static unique_ptr<LocalTableFunctionState> AppendTreeLocalState(
-        ClientContext &context, TableFunctionBindInput &input,
-        vector<LogicalType> &return_types, vector<string> &names) {
-        return nullptr;
-    }
-
-    struct SillyTree {
-        std::map<Value, Value> &values;
-        std::unique_ptr<_lock> lock;
-        SillyTree(std::map<Value, Value> &values, std::unique_ptr<_lock> lock): values(values), lock(std::move(lock)) {}
-    };
-
-    static unique_ptr<SillyTree> GetTree(idx_t tree_id) {
-        auto l = _lock(silly_btree_store_mutex_lock);
-        auto it = silly_btree_store.find(tree_id);
-        if (it == silly_btree_store.end()) {
-            silly_btree_store[tree_id] = std::map<SillyTreeKey, SillyTreeValue>();
-            silly_btree_store_mutex[tree_id] = make_uniq<std::mutex>();
-        }
-
-    }
-
-    static void AppendTreeImplementation(ClientContext &context, duckdb::TableFunctionInput &data_p,DataChunk &output) {
-
-    }
-
-    static void RegisterSillyBtreeStore(DatabaseHeader &instance) {
-        //TODO: register store functions
-    }
-}
\ No newline at end of file
+
+//! Strict weak ordering of stored keys, DuckDB's own comparison
+template <class K>
+static bool SillyKeyLess(const K &a, const K &b) {
+	return LessThan::Operation<K>(a, b);
+}
+
+//! B+tree with CAPACITY keys per node. Leaves are linked for range scans and hold the slot of every key's value in
+//! the tree's value store next to the key array. Not thread safe, SillyTree shards guard it.
+template <class K>
+class BPlusTree {
+public:
+	static constexpr idx_t CAPACITY = 64;
+
+	struct Node {
+		explicit Node(bool leaf) : leaf(leaf) {
+		}
+		virtual ~Node() {
+		}
+		bool leaf;
+		idx_t count = 0;
+		//! one spare slot, a node is split once it overflows
+		K keys[CAPACITY + 1];
+	};
+	struct Inner : Node {
+		Inner() : Node(false) {
+		}
+		unique_ptr<Node> children[CAPACITY + 2];
+	};
+	struct Leaf : Node {
+		Leaf() : Node(true) {
+		}
+		idx_t slots[CAPACITY + 1];
+		Leaf *next = nullptr;
+	};
+
+	BPlusTree() : root(make_uniq<Leaf>()) {
+	}
+
+	//! Inserts or overwrites, returns true for a new key. An overwritten key returns its previous slot in replaced.
+	//! New keys are stored as own(key), which lets string keys be copied only once they are known to be new.
+	template <class OWN>
+	bool Insert(const K &key, idx_t slot, idx_t &replaced, OWN &&own) {
+		K separator;
+		unique_ptr<Node> sibling;
+		const auto inserted = Insert(*root, key, slot, replaced, own, separator, sibling);
+		if (sibling) {
+			auto new_root = make_uniq<Inner>();
+			new_root->keys[0] = separator;
+			new_root->children[0] = std::move(root);
+			new_root->children[1] = std::move(sibling);
+			new_root->count = 1;
+			root = std::move(new_root);
+		}
+		size += inserted;
+		return inserted;
+	}
+
+	bool Get(const K &key, idx_t &slot) const {
+		auto &leaf = FindLeaf(key);
+		const auto pos = std::lower_bound(leaf.keys, leaf.keys + leaf.count, key, SillyKeyLess<K>) - leaf.keys;
+		if (idx_t(pos) == leaf.count || SillyKeyLess(key, leaf.keys[pos])) {
+			return false;
+		}
+		slot = leaf.slots[pos];
+		return true;
+	}
+
+	//! Leaf and position of the first key >= key (> key if after, nullptr: the first key of the tree). The position
+	//! may be past the leaf's last key, the entry then is the first one of the next leaf.
+	const Leaf *Seek(const K *key, bool after, idx_t &pos) const {
+		if (!key) {
+			pos = 0;
+			return &LeftmostLeaf();
+		}
+		auto &leaf = FindLeaf(*key);
+		pos = (after ? std::upper_bound(leaf.keys, leaf.keys + leaf.count, *key, SillyKeyLess<K>)
+		             : std::lower_bound(leaf.keys, leaf.keys + leaf.count, *key, SillyKeyLess<K>)) -
+		      leaf.keys;
+		return &leaf;
+	}
+
+	//! Separator keys of the inner levels up to levels below the root, in key order
+	void Separators(idx_t levels, vector<K> &result) const {
+		Separators(*root, levels, result);
+	}
+
+	idx_t Size() const {
+		return size;
+	}
+
+private:
+	const Leaf &FindLeaf(const K &key) const {
+		const Node *node = root.get();
+		while (!node->leaf) {
+			auto &inner = static_cast<const Inner &>(*node);
+			const auto child =
+			    std::upper_bound(inner.keys, inner.keys + inner.count, key, SillyKeyLess<K>) - inner.keys;
+			node = inner.children[child].get();
+		}
+		return static_cast<const Leaf &>(*node);
+	}
+
+	const Leaf &LeftmostLeaf() const {
+		const Node *node = root.get();
+		while (!node->leaf) {
+			node = static_cast<const Inner &>(*node).children[0].get();
+		}
+		return static_cast<const Leaf &>(*node);
+	}
+
+	static void Separators(const Node &node, idx_t levels, vector<K> &result) {
+		if (node.leaf || levels == 0) {
+			return;
+		}
+		auto &inner = static_cast<const Inner &>(node);
+		for (idx_t i = 0; i <= inner.count; i++) {
+			Separators(*inner.children[i], levels - 1, result);
+			if (i < inner.count) {
+				result.push_back(inner.keys[i]);
+			}
+		}
+	}
+
+	//! Inserts below node; when node overflows it is split and the upper half returned in sibling
+	template <class OWN>
+	bool Insert(Node &node, const K &key, idx_t slot, idx_t &replaced, OWN &own, K &separator,
+	            unique_ptr<Node> &sibling) {
+		if (node.leaf) {
+			auto &leaf = static_cast<Leaf &>(node);
+			const idx_t pos = std::lower_bound(leaf.keys, leaf.keys + leaf.count, key, SillyKeyLess<K>) - leaf.keys;
+			if (pos < leaf.count && !SillyKeyLess(key, leaf.keys[pos])) {
+				replaced = leaf.slots[pos];
+				leaf.slots[pos] = slot;
+				return false;
+			}
+			for (idx_t i = leaf.count; i > pos; i--) {
+				leaf.keys[i] = leaf.keys[i - 1];
+				leaf.slots[i] = leaf.slots[i - 1];
+			}
+			leaf.keys[pos] = own(key);
+			leaf.slots[pos] = slot;
+			leaf.count++;
+			if (leaf.count > CAPACITY) {
+				auto right = make_uniq<Leaf>();
+				const auto mid = leaf.count / 2;
+				for (idx_t i = mid; i < leaf.count; i++) {
+					right->keys[i - mid] = leaf.keys[i];
+					right->slots[i - mid] = leaf.slots[i];
+				}
+				right->count = leaf.count - mid;
+				leaf.count = mid;
+				right->next = leaf.next;
+				leaf.next = right.get();
+				separator = right->keys[0];
+				sibling = std::move(right);
+			}
+			return true;
+		}
+		auto &inner = static_cast<Inner &>(node);
+		const idx_t child = std::upper_bound(inner.keys, inner.keys + inner.count, key, SillyKeyLess<K>) - inner.keys;
+		K child_separator;
+		unique_ptr<Node> child_sibling;
+		const auto inserted =
+		    Insert(*inner.children[child], key, slot, replaced, own, child_separator, child_sibling);
+		if (!child_sibling) {
+			return inserted;
+		}
+		for (idx_t i = inner.count; i > child; i--) {
+			inner.keys[i] = inner.keys[i - 1];
+			inner.children[i + 1] = std::move(inner.children[i]);
+		}
+		inner.keys[child] = child_separator;
+		inner.children[child + 1] = std::move(child_sibling);
+		inner.count++;
+		if (inner.count > CAPACITY) {
+			// the middle key moves up, the keys right of it go to the new sibling
+			auto right = make_uniq<Inner>();
+			const auto mid = inner.count / 2;
+			for (idx_t i = mid + 1; i < inner.count; i++) {
+				right->keys[i - mid - 1] = inner.keys[i];
+			}
+			for (idx_t i = mid + 1; i <= inner.count; i++) {
+				right->children[i - mid - 1] = std::move(inner.children[i]);
+			}
+			right->count = inner.count - mid - 1;
+			separator = inner.keys[mid];
+			inner.count = mid;
+			sibling = std::move(right);
+		}
+		return inserted;
+	}
+
+	unique_ptr<Node> root;
+	idx_t size = 0;
+};
+
+//! Values of a tree in vectors of STANDARD_VECTOR_SIZE rows, addressed by slot. Leaves only hold slots, so values of
+//! any type are copied in and out a vector at a time. Slots of overwritten values are reused.
+class SillyValueStore {
+public:
+	explicit SillyValueStore(LogicalType type_p) : type(std::move(type_p)) {
+	}
+
+	//! Copies the count rows of values selected by sel into free slots, which are returned in slots
+	void Append(Vector &values, SelectionVector &sel, idx_t count, idx_t slots[]) {
+		lock_guard<mutex> guard(lock);
+		for (idx_t i = 0; i < count; i++) {
+			if (!free_slots.empty()) {
+				slots[i] = free_slots.back();
+				free_slots.pop_back();
+				continue;
+			}
+			if (next_slot == blocks.size() * STANDARD_VECTOR_SIZE) {
+				blocks.push_back(make_uniq<Vector>(type, STANDARD_VECTOR_SIZE));
+			}
+			slots[i] = next_slot++;
+		}
+		// consecutive slots of a block are filled by one copy
+		for (idx_t begin = 0, end; begin < count; begin = end) {
+			for (end = begin + 1; end < count && slots[end] == slots[end - 1] + 1 &&
+			                      slots[end] % STANDARD_VECTOR_SIZE != 0;
+			     end++) {
+			}
+			const SelectionVector run_sel(sel.data() + begin);
+			VectorOperations::Copy(values, *blocks[slots[begin] / STANDARD_VECTOR_SIZE], run_sel, end - begin, 0,
+			                       slots[begin] % STANDARD_VECTOR_SIZE);
+		}
+	}
+
+	//! Copies the values of count slots to result, starting at row offset
+	void Fetch(const idx_t slots[], idx_t count, Vector &result, idx_t offset) {
+		lock_guard<mutex> guard(lock);
+		SelectionVector block_sel(STANDARD_VECTOR_SIZE);
+		// every run of rows stored in the same block is one copy
+		for (idx_t begin = 0, end; begin < count; begin = end) {
+			const auto block = slots[begin] / STANDARD_VECTOR_SIZE;
+			for (end = begin; end < count && slots[end] / STANDARD_VECTOR_SIZE == block; end++) {
+				block_sel.set_index(end - begin, slots[end] % STANDARD_VECTOR_SIZE);
+			}
+			VectorOperations::Copy(*blocks[block], result, block_sel, end - begin, 0, offset + begin);
+		}
+	}
+
+	Value Get(idx_t slot) {
+		lock_guard<mutex> guard(lock);
+		return blocks[slot / STANDARD_VECTOR_SIZE]->GetValue(slot % STANDARD_VECTOR_SIZE);
+	}
+
+	//! Releases the slot of an overwritten value, the caller holds the lock of the shard that referenced it
+	void Free(idx_t slot) {
+		lock_guard<mutex> guard(lock);
+		free_slots.push_back(slot);
+	}
+
+private:
+	mutex lock;
+	const LogicalType type;
+	vector<unique_ptr<Vector>> blocks;
+	idx_t next_slot = 0;
+	vector<idx_t> free_slots;
+};
+
+//! Backing memory of the string keys of a tree, which live as long as the tree
+struct SillyKeyArena {
+	mutex lock;
+	StringHeap heap;
+};
+
+template <class K>
+static K OwnSillyTreeKey(SillyKeyArena &arena, const K &key) {
+	return key;
+}
+static string_t OwnSillyTreeKey(SillyKeyArena &arena, const string_t &key) {
+	if (key.IsInlined()) {
+		return key;
+	}
+	lock_guard<mutex> guard(arena.lock);
+	return arena.heap.AddBlob(key);
+}
+
+template <class K>
+static void CheckSillyTreeKey(const K &key) {
+}
+static void CheckSillyTreeKey(const double &key) {
+	if (std::isnan(key)) {
+		throw InvalidInputException("silly_btree_store: NaN keys are not supported");
+	}
+}
+
+class SillyTreeCursor {
+public:
+	virtual ~SillyTreeCursor() {
+	}
+	//! Writes up to STANDARD_VECTOR_SIZE entries to the key and value vectors, returns 0 when exhausted
+	virtual idx_t Fetch(Vector &keys, Vector &values) = 0;
+};
+
+//! A named ordered key/value store. Keys are BIGINT, UBIGINT, HUGEINT, UHUGEINT, DOUBLE or VARCHAR, values any type.
+//! Entries are range partitioned over SHARDS independently locked B+trees, so concurrent appends and lookups only
+//! contend when they hit the same key range, and an ordered scan reads the shards covering its range one after the
+//! other.
+class SillyTree {
+public:
+	static constexpr idx_t SHARDS = 16;
+
+	SillyTree(LogicalType key_type_p, LogicalType value_type_p)
+	    : key_type(std::move(key_type_p)), value_type(std::move(value_type_p)) {
+	}
+	virtual ~SillyTree() {
+	}
+
+	//! Inserts count rows, keys must already be of key_type; NULL keys are ignored. Returns the number of new keys.
+	virtual idx_t Append(Vector &keys, Vector &values, idx_t count) = 0;
+	virtual bool Get(const Value &key, Value &value) = 0;
+	//! Ordered scan over the entries with lo <= key <= hi (key < hi unless hi_inclusive, NULL: unbounded). The cursor
+	//! reads lazily, entries appended to the range after the scan started may or may not be returned.
+	virtual unique_ptr<SillyTreeCursor> Scan(const Value &lo, const Value &hi, bool hi_inclusive) = 0;
+	//! Up to parts - 1 ascending keys strictly inside (lo, hi) that cut the range into parts of similar size,
+	//! taken from the separator keys of the shards' upper levels
+	virtual vector<Value> SplitPoints(const Value &lo, const Value &hi, idx_t parts) = 0;
+	virtual idx_t Size() = 0;
+
+	//! Storage type of keys of the given type: 64 and 128 bit integers are kept as they are, narrower integers
+	//! widen to BIGINT and other numbers to DOUBLE
+	static LogicalType KeyStorageType(const LogicalType &type) {
+		switch (type.id()) {
+		case LogicalTypeId::UBIGINT:
+		case LogicalTypeId::HUGEINT:
+		case LogicalTypeId::UHUGEINT:
+		case LogicalTypeId::VARCHAR:
+			return type.id();
+		default:
+			break;
+		}
+		if (type.IsIntegral() || type.id() == LogicalTypeId::BOOLEAN) {
+			return LogicalType::BIGINT;
+		}
+		if (type.IsNumeric()) {
+			return LogicalType::DOUBLE;
+		}
+		throw NotImplementedException("silly_btree_store: unsupported key type %s", type.ToString());
+	}
+
+	const LogicalType key_type;
+	const LogicalType value_type;
+};
+
+//! A lookup key or scan bound converted to the stored key type. String keys point into storage, so the bound is
+//! neither copied nor moved.
+template <class K>
+struct SillyTreeBound {
+	explicit SillyTreeBound(const Value &value) : is_set(!value.IsNull()) {
+		if (is_set) {
+			Set(value);
+		}
+	}
+	SillyTreeBound(const SillyTreeBound &) = delete;
+
+	void Set(const Value &value) {
+		key = value.GetValue<K>();
+		CheckSillyTreeKey(key);
+	}
+
+	bool is_set;
+	string storage;
+	K key;
+};
+
+template <>
+void SillyTreeBound<string_t>::Set(const Value &value) {
+	storage = StringValue::Get(value);
+	key = string_t(storage.c_str(), UnsafeNumericCast<uint32_t>(storage.size()));
+}
+
+static Value SillyTreeValue(int64_t key) {
+	return Value::BIGINT(key);
+}
+static Value SillyTreeValue(uint64_t key) {
+	return Value::UBIGINT(key);
+}
+static Value SillyTreeValue(hugeint_t key) {
+	return Value::HUGEINT(key);
+}
+static Value SillyTreeValue(uhugeint_t key) {
+	return Value::UHUGEINT(key);
+}
+static Value SillyTreeValue(double key) {
+	return Value::DOUBLE(key);
+}
+static Value SillyTreeValue(const string_t &key) {
+	return Value(key.GetString());
+}
+
+//! Copies count keys of a leaf to keys, starting at row offset
+template <class K>
+static void WriteSillyTreeKeys(Vector &keys, idx_t offset, const K *source, idx_t count) {
+	memcpy(FlatVector::GetData<K>(keys) + offset, source, count * sizeof(K));
+}
+static void WriteSillyTreeKeys(Vector &keys, idx_t offset, const string_t *source, idx_t count) {
+	auto target = FlatVector::GetData<string_t>(keys) + offset;
+	for (idx_t i = 0; i < count; i++) {
+		target[i] = source[i].IsInlined() ? source[i] : StringVector::AddString(keys, source[i]);
+	}
+}
+
+template <class K>
+class TypedSillyTree : public SillyTree {
+public:
+	//! Until the tree holds this many keys everything lives in the first shard, then the shards are cut once at the
+	//! quantiles of the keys seen so far
+	static constexpr idx_t REBALANCE_ROWS = 64 * 1024;
+
+	TypedSillyTree(LogicalType key_type, LogicalType value_type)
+	    : SillyTree(std::move(key_type), std::move(value_type)), values(this->value_type) {
+	}
+
+	//! Sorts the batch by key and copies its values into the value store with one copy per block, then inserts the
+	//! keys shard by shard, each shard lock being taken once per batch
+	idx_t Append(Vector &keys, Vector &values_p, idx_t count) override {
+		UnifiedVectorFormat key_format;
+		keys.ToUnifiedFormat(count, key_format);
+		const auto key_data = UnifiedVectorFormat::GetData<K>(key_format);
+		auto key_of = [&](sel_t row) -> const K & {
+			return key_data[key_format.sel->get_index(row)];
+		};
+		SelectionVector rows(count);
+		idx_t valid = 0;
+		for (idx_t row = 0; row < count; row++) {
+			if (key_format.validity.RowIsValid(key_format.sel->get_index(row))) {
+				CheckSillyTreeKey(key_of(sel_t(row)));
+				rows.set_index(valid++, row);
+			}
+		}
+		// shards cover ascending key ranges, so a sorted batch is a run per shard; a stable sort keeps the last of
+		// duplicate keys winning
+		std::stable_sort(rows.data(), rows.data() + valid,
+		                 [&](sel_t a, sel_t b) { return SillyKeyLess(key_of(a), key_of(b)); });
+		vector<idx_t> slots(valid);
+		values.Append(values_p, rows, valid, slots.data());
+		idx_t inserted = 0;
+		for (idx_t begin = 0, end; begin < valid; begin = end) {
+			const auto layout = balanced.load();
+			const auto shard_idx = ShardOf(key_of(rows.get_index(begin)), layout);
+			for (end = begin + 1; end < valid && ShardOf(key_of(rows.get_index(end)), layout) == shard_idx; end++) {
+			}
+			auto &shard = shards[shard_idx];
+			lock_guard<mutex> guard(shard.lock);
+			if (balanced.load() != layout) {
+				// the shards were cut meanwhile, route the run again
+				end = begin;
+				continue;
+			}
+			for (idx_t i = begin; i < end; i++) {
+				idx_t replaced;
+				if (shard.tree.Insert(key_of(rows.get_index(i)), slots[i], replaced,
+				                      [&](const K &key) { return OwnSillyTreeKey(arena, key); })) {
+					inserted++;
+				} else {
+					values.Free(replaced);
+				}
+			}
+			shard.version++;
+		}
+		size += inserted;
+		if (!balanced.load() && size.load() >= REBALANCE_ROWS) {
+			Rebalance();
+		}
+		return inserted;
+	}
+
+	bool Get(const Value &key, Value &value) override {
+		const SillyTreeBound<K> bound(key);
+		while (true) {
+			const auto layout = balanced.load();
+			auto &shard = shards[ShardOf(bound.key, layout)];
+			lock_guard<mutex> guard(shard.lock);
+			if (balanced.load() != layout) {
+				continue;
+			}
+			idx_t slot;
+			if (!shard.tree.Get(bound.key, slot)) {
+				return false;
+			}
+			value = values.Get(slot);
+			return true;
+		}
+	}
+
+	unique_ptr<SillyTreeCursor> Scan(const Value &lo, const Value &hi, bool hi_inclusive) override {
+		return make_uniq<Cursor>(*this, lo, hi, hi_inclusive);
+	}
+
+	vector<Value> SplitPoints(const Value &lo, const Value &hi, idx_t parts) override {
+		// shards and their separators both ascend, so the concatenation is sorted
+		vector<K> separators;
+		for (idx_t shard = 0; shard < SHARDS; shard++) {
+			lock_guard<mutex> guard(shards[shard].lock);
+			if (shard > 0 && balanced.load()) {
+				separators.push_back(boundaries[shard - 1]);
+			}
+			shards[shard].tree.Separators(2, separators);
+		}
+		const SillyTreeBound<K> lo_key(lo);
+		const SillyTreeBound<K> hi_key(hi);
+		vector<K> inside;
+		for (auto &separator : separators) {
+			if ((!lo_key.is_set || SillyKeyLess(lo_key.key, separator)) &&
+			    (!hi_key.is_set || SillyKeyLess(separator, hi_key.key))) {
+				inside.push_back(separator);
+			}
+		}
+		vector<Value> result;
+		if (parts <= 1 || inside.empty()) {
+			return result;
+		}
+		const auto points = MinValue<idx_t>(parts - 1, inside.size());
+		idx_t previous = DConstants::INVALID_INDEX;
+		for (idx_t i = 1; i <= points; i++) {
+			const auto pick = i * inside.size() / (points + 1);
+			if (pick != previous) {
+				result.push_back(SillyTreeValue(inside[pick]));
+				previous = pick;
+			}
+		}
+		return result;
+	}
+
+	idx_t Size() override {
+		return size.load();
+	}
+
+private:
+	struct Shard {
+		mutex lock;
+		BPlusTree<K> tree;
+		//! bumped on every change, cursors holding a leaf position of an older version seek again
+		idx_t version = 0;
+	};
+
+	//! Walks the leaves of one shard after the other, holding a shard's lock only while it fills the current vector
+	class Cursor : public SillyTreeCursor {
+	public:
+		Cursor(TypedSillyTree &tree, const Value &lo_p, const Value &hi_p, bool hi_inclusive)
+		    : tree(tree), lo(lo_p), hi(hi_p), hi_inclusive(hi_inclusive) {
+		}
+
+		idx_t Fetch(Vector &keys, Vector &values) override {
+			idx_t count = 0;
+			while (!done && count < STANDARD_VECTOR_SIZE) {
+				auto &shard = tree.shards[shard_idx];
+				lock_guard<mutex> guard(shard.lock);
+				const auto current_layout = tree.balanced.load();
+				if (!started || current_layout != layout) {
+					// first fetch or the shards were cut since: find the shard holding the next key
+					const K *resume = has_last ? &last : lo.is_set ? &lo.key : nullptr;
+					const auto target = resume ? tree.ShardOf(*resume, current_layout) : 0;
+					started = true;
+					layout = current_layout;
+					leaf = nullptr;
+					if (target != shard_idx) {
+						shard_idx = target;
+						continue;
+					}
+				}
+				if (!leaf || version != shard.version) {
+					leaf = has_last ? shard.tree.Seek(&last, true, pos)
+					                : shard.tree.Seek(lo.is_set ? &lo.key : nullptr, false, pos);
+					version = shard.version;
+				}
+				const auto begin = count;
+				while (leaf && count < STANDARD_VECTOR_SIZE) {
+					auto end = leaf->count;
+					if (hi.is_set) {
+						end = (hi_inclusive ? std::upper_bound(leaf->keys + pos, leaf->keys + leaf->count, hi.key,
+						                                       SillyKeyLess<K>)
+						                    : std::lower_bound(leaf->keys + pos, leaf->keys + leaf->count, hi.key,
+						                                       SillyKeyLess<K>)) -
+						      leaf->keys;
+					}
+					const auto take = MinValue<idx_t>(end - pos, STANDARD_VECTOR_SIZE - count);
+					WriteSillyTreeKeys(keys, count, leaf->keys + pos, take);
+					memcpy(slots + count, leaf->slots + pos, take * sizeof(idx_t));
+					count += take;
+					pos += take;
+					if (take > 0) {
+						last = leaf->keys[pos - 1];
+						has_last = true;
+					}
+					if (pos < end) {
+						break;
+					}
+					if (end < leaf->count) {
+						done = true;
+						break;
+					}
+					leaf = leaf->next;
+					pos = 0;
+				}
+				// values are copied while the shard lock keeps their slots referenced
+				tree.values.Fetch(slots + begin, count - begin, values, begin);
+				if (!leaf && !done) {
+					// the shard is exhausted, go on with the next one unless it starts past hi
+					if (!layout || shard_idx + 1 == SHARDS ||
+					    (hi.is_set && (hi_inclusive ? SillyKeyLess(hi.key, tree.boundaries[shard_idx])
+					                                : !SillyKeyLess(tree.boundaries[shard_idx], hi.key)))) {
+						done = true;
+					} else {
+						shard_idx++;
+					}
+				}
+			}
+			return count;
+		}
+
+	private:
+		TypedSillyTree &tree;
+		const SillyTreeBound<K> lo;
+		const SillyTreeBound<K> hi;
+		const bool hi_inclusive;
+		bool started = false;
+		bool done = false;
+		//! the position of the next entry, valid while the shard's version and the layout are unchanged
+		bool layout = false;
+		idx_t shard_idx = 0;
+		const typename BPlusTree<K>::Leaf *leaf = nullptr;
+		idx_t pos = 0;
+		idx_t version = 0;
+		//! the last key returned, the scan resumes after it once the position is stale
+		K last;
+		bool has_last = false;
+		idx_t slots[STANDARD_VECTOR_SIZE];
+	};
+
+	idx_t ShardOf(const K &key, bool layout) const {
+		if (!layout) {
+			return 0;
+		}
+		return std::upper_bound(boundaries, boundaries + SHARDS - 1, key, SillyKeyLess<K>) - boundaries;
+	}
+
+	//! Cuts the first shard into SHARDS key ranges of equal size, once. All shard locks are held while the entries
+	//! move, appends and cursors that routed with the old layout notice the change under the shard lock.
+	void Rebalance() {
+		lock_guard<mutex> rebalance_guard(rebalance_lock);
+		if (balanced.load()) {
+			return;
+		}
+		vector<unique_lock<mutex>> guards;
+		for (auto &shard : shards) {
+			guards.emplace_back(shard.lock);
+		}
+		vector<std::pair<K, idx_t>> entries;
+		idx_t pos;
+		for (auto leaf = shards[0].tree.Seek(nullptr, false, pos); leaf; leaf = leaf->next) {
+			for (idx_t i = 0; i < leaf->count; i++) {
+				entries.emplace_back(leaf->keys[i], leaf->slots[i]);
+			}
+		}
+		for (idx_t shard = 1; shard < SHARDS; shard++) {
+			boundaries[shard - 1] = entries[shard * entries.size() / SHARDS].first;
+		}
+		BPlusTree<K> trees[SHARDS];
+		for (auto &entry : entries) {
+			idx_t replaced;
+			trees[ShardOf(entry.first, true)].Insert(entry.first, entry.second, replaced,
+			                                         [](const K &key) { return key; });
+		}
+		for (idx_t shard = 0; shard < SHARDS; shard++) {
+			shards[shard].tree = std::move(trees[shard]);
+			shards[shard].version++;
+		}
+		balanced.store(true);
+	}
+
+	Shard shards[SHARDS];
+	//! boundaries[i - 1] is the smallest key of shard i, set once when balanced becomes true
+	K boundaries[SHARDS - 1];
+	atomic<bool> balanced {false};
+	mutex rebalance_lock;
+	atomic<idx_t> size {0};
+	SillyValueStore values;
+	SillyKeyArena arena;
+};
+
+//! All trees of a database, by tree id
+class SillyBTreeStore : public ObjectCacheEntry {
+public:
+	static string ObjectType() {
+		return "chsql_silly_btree_store";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	static SillyBTreeStore &Get(ClientContext &context) {
+		return *ObjectCache::GetObjectCache(context).GetOrCreate<SillyBTreeStore>(ObjectType());
+	}
+
+	shared_ptr<SillyTree> GetTree(idx_t tree_id) {
+		lock_guard<mutex> guard(lock);
+		auto entry = trees.find(tree_id);
+		return entry == trees.end() ? nullptr : entry->second;
+	}
+
+	//! Returns the tree, creating it with the given types on first use
+	shared_ptr<SillyTree> GetOrCreateTree(idx_t tree_id, const LogicalType &key_type, const LogicalType &value_type) {
+		lock_guard<mutex> guard(lock);
+		auto &tree = trees[tree_id];
+		if (!tree) {
+			const auto storage_type = SillyTree::KeyStorageType(key_type);
+			switch (storage_type.id()) {
+			case LogicalTypeId::BIGINT:
+				tree = make_shared_ptr<TypedSillyTree<int64_t>>(storage_type, value_type);
+				break;
+			case LogicalTypeId::UBIGINT:
+				tree = make_shared_ptr<TypedSillyTree<uint64_t>>(storage_type, value_type);
+				break;
+			case LogicalTypeId::HUGEINT:
+				tree = make_shared_ptr<TypedSillyTree<hugeint_t>>(storage_type, value_type);
+				break;
+			case LogicalTypeId::UHUGEINT:
+				tree = make_shared_ptr<TypedSillyTree<uhugeint_t>>(storage_type, value_type);
+				break;
+			case LogicalTypeId::DOUBLE:
+				tree = make_shared_ptr<TypedSillyTree<double>>(storage_type, value_type);
+				break;
+			default:
+				tree = make_shared_ptr<TypedSillyTree<string_t>>(storage_type, value_type);
+				break;
+			}
+		}
+		return tree;
+	}
+
+private:
+	mutex lock;
+	unordered_map<idx_t, shared_ptr<SillyTree>> trees;
+};
+
+static shared_ptr<SillyTree> GetExistingTree(ClientContext &context, idx_t tree_id) {
+	auto tree = SillyBTreeStore::Get(context).GetTree(tree_id);
+	if (!tree) {
+		throw BinderException("silly_btree_store: tree %llu does not exist", tree_id);
+	}
+	return tree;
+}
+
+//! Casts keys and values to the tree's types and appends them
+static idx_t AppendToTree(ClientContext &context, SillyTree &tree, Vector &keys, Vector &values, idx_t count) {
+	Vector cast_keys(tree.key_type, count);
+	Vector cast_values(tree.value_type, count);
+	VectorOperations::Cast(context, keys, cast_keys, count);
+	VectorOperations::Cast(context, values, cast_values, count);
+	return tree.Append(cast_keys, cast_values, count);
+}
+
+struct AppendTreeData : TableFunctionData {
+	idx_t tree_id;
+	Value key;
+	Value value;
+	LogicalType key_type;
+	LogicalType value_type;
+};
+
+struct AppendTreeState : GlobalTableFunctionState {
+	bool done = false;
+};
+
+struct AppendTreeLocalState : LocalTableFunctionState {
+	idx_t appended = 0;
+};
+
+static unique_ptr<FunctionData> AppendTreeBind(ClientContext &context, TableFunctionBindInput &input,
+											   vector<LogicalType> &return_types, vector<string> &names) {
+	auto res = make_uniq<AppendTreeData>();
+	res->tree_id = input.inputs[0].GetValue<idx_t>();
+	if (input.inputs.size() == 3) {
+		res->key = input.inputs[1];
+		res->value = input.inputs[2];
+		res->key_type = res->key.type();
+		res->value_type = res->value.type();
+	} else {
+		if (input.input_table_types.size() != 2) {
+			throw BinderException("tree_append: the input table needs exactly two columns, key and value");
+		}
+		res->key_type = input.input_table_types[0];
+		res->value_type = input.input_table_types[1];
+	}
+	// validates the key type before anything runs
+	SillyTree::KeyStorageType(res->key_type);
+	return_types.push_back(LogicalType::BIGINT);
+	names.push_back("appended");
+	return std::move(res);
+}
+
+static unique_ptr<GlobalTableFunctionState> AppendTreeInit(ClientContext &context, TableFunctionInitInput &input) {
+	return make_uniq<AppendTreeState>();
+}
+
+static unique_ptr<LocalTableFunctionState> AppendTreeInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+															   GlobalTableFunctionState *global_state) {
+	return make_uniq<AppendTreeLocalState>();
+}
+
+//! tree_append(tree_id, key, value): a single pair
+static void AppendTreeImplementation(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &data = data_p.bind_data->Cast<AppendTreeData>();
+	auto &state = data_p.global_state->Cast<AppendTreeState>();
+	if (state.done) {
+		return;
+	}
+	state.done = true;
+	auto tree = SillyBTreeStore::Get(context).GetOrCreateTree(data.tree_id, data.key_type, data.value_type);
+	Vector keys(data.key);
+	Vector values(data.value);
+	output.SetValue(0, 0, Value::BIGINT(int64_t(AppendToTree(context, *tree, keys, values, 1))));
+	output.SetCardinality(1);
+}
+
+//! tree_append(tree_id, (SELECT key, value ...)): appends every input chunk, each worker reports its count at the end
+static OperatorResultType AppendTreeInOut(ExecutionContext &context, TableFunctionInput &data_p, DataChunk &input,
+										  DataChunk &output) {
+	auto &data = data_p.bind_data->Cast<AppendTreeData>();
+	auto &local = data_p.local_state->Cast<AppendTreeLocalState>();
+	auto tree = SillyBTreeStore::Get(context.client).GetOrCreateTree(data.tree_id, data.key_type, data.value_type);
+	local.appended += AppendToTree(context.client, *tree, input.data[0], input.data[1], input.size());
+	return OperatorResultType::NEED_MORE_INPUT;
+}
+
+static OperatorFinalizeResultType AppendTreeInOutFinal(ExecutionContext &context, TableFunctionInput &data_p,
+													   DataChunk &output) {
+	auto &local = data_p.local_state->Cast<AppendTreeLocalState>();
+	output.SetValue(0, 0, Value::BIGINT(int64_t(local.appended)));
+	output.SetCardinality(1);
+	return OperatorFinalizeResultType::FINISHED;
+}
+
+struct TreeReadData : TableFunctionData {
+	idx_t tree_id;
+	shared_ptr<SillyTree> tree;
+	Value lo;
+	Value hi;
+};
+
+struct TreeReadState : GlobalTableFunctionState {
+	bool done = false;
+	unique_ptr<SillyTreeCursor> cursor;
+};
+
+static unique_ptr<FunctionData> TreeReadBind(ClientContext &context, TableFunctionBindInput &input,
+											 vector<LogicalType> &return_types, vector<string> &names) {
+	auto res = make_uniq<TreeReadData>();
+	res->tree_id = input.inputs[0].GetValue<idx_t>();
+	res->tree = GetExistingTree(context, res->tree_id);
+	if (input.inputs.size() == 2) {
+		// tree_get: a point range
+		res->lo = res->hi = input.inputs[1].DefaultCastAs(res->tree->key_type);
+		if (res->lo.IsNull()) {
+			throw BinderException("tree_get: key must not be NULL");
+		}
+	} else {
+		res->lo = input.inputs[1].DefaultCastAs(res->tree->key_type);
+		res->hi = input.inputs[2].DefaultCastAs(res->tree->key_type);
+	}
+	return_types.push_back(res->tree->key_type);
+	return_types.push_back(res->tree->value_type);
+	names.push_back("key");
+	names.push_back("value");
+	return std::move(res);
+}
+
+static unique_ptr<GlobalTableFunctionState> TreeReadInit(ClientContext &context, TableFunctionInitInput &input) {
+	return make_uniq<TreeReadState>();
+}
+
+static void TreeGetImplementation(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &data = data_p.bind_data->Cast<TreeReadData>();
+	auto &state = data_p.global_state->Cast<TreeReadState>();
+	if (state.done) {
+		return;
+	}
+	state.done = true;
+	Value value;
+	if (data.tree->Get(data.lo, value)) {
+		output.SetValue(0, 0, data.lo);
+		output.SetValue(1, 0, value);
+		output.SetCardinality(1);
+	}
+}
+
+static void TreeRangeScanImplementation(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &data = data_p.bind_data->Cast<TreeReadData>();
+	auto &state = data_p.global_state->Cast<TreeReadState>();
+	if (state.done) {
+		return;
+	}
+	if (!state.cursor) {
+		state.cursor = data.tree->Scan(data.lo, data.hi, true);
+	}
+	const auto count = state.cursor->Fetch(output.data[0], output.data[1]);
+	output.SetCardinality(count);
+	if (count == 0) {
+		state.done = true;
+		state.cursor.reset();
+	}
+}
+
+//! One slice [lo, hi) of a tree_scan, the last one includes hi
+struct TreeScanRange {
+	Value lo;
+	Value hi;
+	bool hi_inclusive;
+};
+
+struct TreeScanGlobalState : GlobalTableFunctionState {
+	mutex lock;
+	vector<TreeScanRange> ranges;
+	idx_t next_range = 0;
+
+	idx_t MaxThreads() const override {
+		return ranges.size();
+	}
+};
+
+struct TreeScanLocalState : LocalTableFunctionState {
+	idx_t range_idx = DConstants::INVALID_INDEX;
+	unique_ptr<SillyTreeCursor> cursor;
+};
+
+//! Ranges smaller than this are not worth a thread of their own
+static constexpr idx_t TREE_SCAN_MIN_RANGE_ROWS = 8 * STANDARD_VECTOR_SIZE;
+
+static unique_ptr<GlobalTableFunctionState> TreeScanInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+	auto &data = input.bind_data->Cast<TreeReadData>();
+	auto res = make_uniq<TreeScanGlobalState>();
+	const auto threads = idx_t(TaskScheduler::GetScheduler(context).NumberOfThreads());
+	const auto parts = MinValue<idx_t>(threads, MaxValue<idx_t>(data.tree->Size() / TREE_SCAN_MIN_RANGE_ROWS, 1));
+	auto lo = data.lo;
+	for (auto &point : data.tree->SplitPoints(data.lo, data.hi, parts)) {
+		res->ranges.push_back(TreeScanRange {lo, point, false});
+		lo = point;
+	}
+	res->ranges.push_back(TreeScanRange {lo, data.hi, true});
+	return std::move(res);
+}
+
+static unique_ptr<LocalTableFunctionState> TreeScanInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+															 GlobalTableFunctionState *global_state) {
+	return make_uniq<TreeScanLocalState>();
+}
+
+//! tree_scan(tree_id, lo, hi): every thread walks the shards over its own key range
+static void TreeScanImplementation(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &data = data_p.bind_data->Cast<TreeReadData>();
+	auto &state = data_p.global_state->Cast<TreeScanGlobalState>();
+	auto &local = data_p.local_state->Cast<TreeScanLocalState>();
+	while (true) {
+		if (!local.cursor) {
+			{
+				lock_guard<mutex> guard(state.lock);
+				if (state.next_range >= state.ranges.size()) {
+					return;
+				}
+				local.range_idx = state.next_range++;
+			}
+			auto &range = state.ranges[local.range_idx];
+			local.cursor = data.tree->Scan(range.lo, range.hi, range.hi_inclusive);
+		}
+		const auto count = local.cursor->Fetch(output.data[0], output.data[1]);
+		if (count > 0) {
+			output.SetCardinality(count);
+			return;
+		}
+		local.cursor.reset();
+	}
+}
+
+//! Ranges are handed out in key order, so the range index keeps the output ordered by key when DuckDB preserves
+//! insertion order
+static idx_t TreeScanGetBatchIndex(ClientContext &context, const FunctionData *bind_data_p,
+								   LocalTableFunctionState *local_state, GlobalTableFunctionState *global_state) {
+	return local_state->Cast<TreeScanLocalState>().range_idx;
+}
+
+void RegisterSillyBTreeStore(DatabaseInstance &instance) {
+	TableFunctionSet append("tree_append");
+	TableFunction append_pair({LogicalType::UBIGINT, LogicalType::ANY, LogicalType::ANY}, AppendTreeImplementation,
+							  AppendTreeBind, AppendTreeInit);
+	append.AddFunction(append_pair);
+	TableFunction append_table({LogicalType::UBIGINT, LogicalType::TABLE}, nullptr, AppendTreeBind, AppendTreeInit,
+							   AppendTreeInitLocal);
+	append_table.in_out_function = AppendTreeInOut;
+	append_table.in_out_function_final = AppendTreeInOutFinal;
+	append.AddFunction(append_table);
+	ExtensionUtil::RegisterFunction(instance, append);
+
+	ExtensionUtil::RegisterFunction(instance, TableFunction("tree_get", {LogicalType::UBIGINT, LogicalType::ANY},
+															TreeGetImplementation, TreeReadBind, TreeReadInit));
+	ExtensionUtil::RegisterFunction(instance,
+									TableFunction("tree_range_scan",
+												  {LogicalType::UBIGINT, LogicalType::ANY, LogicalType::ANY},
+												  TreeRangeScanImplementation, TreeReadBind, TreeReadInit));
+
+	TableFunction tree_scan("tree_scan", {LogicalType::UBIGINT, LogicalType::ANY, LogicalType::ANY},
+							TreeScanImplementation, TreeReadBind, TreeScanInitGlobal, TreeScanInitLocal);
+	tree_scan.get_batch_index = TreeScanGetBatchIndex;
+	ExtensionUtil::RegisterFunction(instance, tree_scan);
+}
+
+} // namespace duckdb
@@ -0,0 +1,92 @@
+#include "table_filter_select.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+
+namespace duckdb {
+
+idx_t SelectTableFilter(Vector &vector, idx_t vector_size, const TableFilter &filter, SelectionVector &sel,
+                        idx_t count) {
+	switch (filter.filter_type) {
+	case TableFilterType::CONSTANT_COMPARISON: {
+		auto &constant_filter = filter.Cast<ConstantFilter>();
+		Vector constant(constant_filter.constant);
+		SelectionVector true_sel(STANDARD_VECTOR_SIZE);
+		idx_t result;
+		switch (constant_filter.comparison_type) {
+		case ExpressionType::COMPARE_EQUAL:
+			result = VectorOperations::Equals(vector, constant, &sel, count, &true_sel, nullptr);
+			break;
+		case ExpressionType::COMPARE_NOTEQUAL:
+			result = VectorOperations::NotEquals(vector, constant, &sel, count, &true_sel, nullptr);
+			break;
+		case ExpressionType::COMPARE_LESSTHAN:
+			result = VectorOperations::LessThan(vector, constant, &sel, count, &true_sel, nullptr);
+			break;
+		case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+			result = VectorOperations::LessThanEquals(vector, constant, &sel, count, &true_sel, nullptr);
+			break;
+		case ExpressionType::COMPARE_GREATERTHAN:
+			result = VectorOperations::GreaterThan(vector, constant, &sel, count, &true_sel, nullptr);
+			break;
+		case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+			result = VectorOperations::GreaterThanEquals(vector, constant, &sel, count, &true_sel, nullptr);
+			break;
+		default:
+			throw NotImplementedException("chsql: unsupported filter comparison %s",
+										  ExpressionTypeToString(constant_filter.comparison_type));
+		}
+		sel.Initialize(true_sel);
+		return result;
+	}
+	case TableFilterType::IS_NULL:
+	case TableFilterType::IS_NOT_NULL: {
+		const bool keep_null = filter.filter_type == TableFilterType::IS_NULL;
+		UnifiedVectorFormat format;
+		vector.ToUnifiedFormat(vector_size, format);
+		idx_t result = 0;
+		for (idx_t i = 0; i < count; i++) {
+			const auto row = sel.get_index(i);
+			if (format.validity.RowIsValid(format.sel->get_index(row)) != keep_null) {
+				sel.set_index(result++, row);
+			}
+		}
+		return result;
+	}
+	case TableFilterType::CONJUNCTION_AND: {
+		for (auto &child : filter.Cast<ConjunctionAndFilter>().child_filters) {
+			count = SelectTableFilter(vector, vector_size, *child, sel, count);
+		}
+		return count;
+	}
+	case TableFilterType::CONJUNCTION_OR: {
+		bool passed[STANDARD_VECTOR_SIZE] = {};
+		for (auto &child : filter.Cast<ConjunctionOrFilter>().child_filters) {
+			SelectionVector child_sel(STANDARD_VECTOR_SIZE);
+			for (idx_t i = 0; i < count; i++) {
+				child_sel.set_index(i, sel.get_index(i));
+			}
+			const auto child_count = SelectTableFilter(vector, vector_size, *child, child_sel, count);
+			for (idx_t i = 0; i < child_count; i++) {
+				passed[child_sel.get_index(i)] = true;
+			}
+		}
+		idx_t result = 0;
+		for (idx_t i = 0; i < count; i++) {
+			const auto row = sel.get_index(i);
+			if (passed[row]) {
+				sel.set_index(result++, row);
+			}
+		}
+		return result;
+	}
+	case TableFilterType::OPTIONAL_FILTER:
+		// optional filters only serve pruning, the original predicate stays in the plan
+		return count;
+	default:
+		throw NotImplementedException("chsql: unsupported filter type");
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,276 @@
+#include "url_functions.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+//! Components of a URL as offsets into the original string, produced by one left-to-right scan.
+//! scheme://user@host:port/path?query#fragment, every component may be empty.
+struct URLComponents {
+	const char *data;
+	idx_t protocol_end = 0;
+	idx_t host_begin = 0;
+	idx_t host_end = 0;
+	idx_t port_begin = 0;
+	idx_t port_end = 0;
+	idx_t path_begin = 0;
+	idx_t path_end = 0;
+	idx_t query_begin = 0;
+	idx_t query_end = 0;
+	idx_t fragment_begin = 0;
+	idx_t fragment_end = 0;
+
+	string_t Slice(idx_t begin, idx_t end) const {
+		return string_t(data + begin, static_cast<uint32_t>(end - begin));
+	}
+	string_t Protocol() const {
+		return Slice(0, protocol_end);
+	}
+	string_t Host() const {
+		return Slice(host_begin, host_end);
+	}
+	string_t Port() const {
+		return Slice(port_begin, port_end);
+	}
+	string_t Path() const {
+		return Slice(path_begin, path_end);
+	}
+	string_t Query() const {
+		return Slice(query_begin, query_end);
+	}
+	string_t Fragment() const {
+		return Slice(fragment_begin, fragment_end);
+	}
+};
+
+static inline bool IsSchemeChar(char c) {
+	return StringUtil::CharacterIsAlphaNumeric(c) || c == '+' || c == '-' || c == '.';
+}
+
+//! Position of the first of '?' or '#' in [begin, end), found with memchr which libc vectorizes
+static inline const char *FindQueryOrFragment(const char *begin, const char *end) {
+	auto question = static_cast<const char *>(memchr(begin, '?', end - begin));
+	auto hash = static_cast<const char *>(memchr(begin, '#', (question ? question : end) - begin));
+	return hash ? hash : (question ? question : end);
+}
+
+static URLComponents SplitURL(string_t url) {
+	URLComponents result;
+	const auto data = url.GetData();
+	const auto size = url.GetSize();
+	result.data = data;
+
+	// scheme: [A-Za-z][A-Za-z0-9+.-]* followed by "://"
+	idx_t pos = 0;
+	if (size > 0 && StringUtil::CharacterIsAlpha(data[0])) {
+		idx_t scheme_end = 1;
+		while (scheme_end < size && IsSchemeChar(data[scheme_end])) {
+			scheme_end++;
+		}
+		if (scheme_end + 3 <= size && memcmp(data + scheme_end, "://", 3) == 0) {
+			result.protocol_end = scheme_end;
+			pos = scheme_end + 3;
+		}
+	}
+	if (pos == 0 && size >= 2 && data[0] == '/' && data[1] == '/') {
+		// protocol-relative "//host/path"
+		pos = 2;
+	}
+
+	// authority runs up to the first '/', '?' or '#'
+	idx_t authority_end = pos;
+	if (pos > 0 || (size > 0 && data[0] != '/')) {
+		while (authority_end < size && data[authority_end] != '/' && data[authority_end] != '?' &&
+			   data[authority_end] != '#') {
+			authority_end++;
+		}
+	}
+	idx_t host_begin = pos;
+	for (idx_t i = pos; i < authority_end; i++) {
+		if (data[i] == '@') {
+			host_begin = i + 1;
+		}
+	}
+	idx_t host_end = authority_end;
+	if (host_begin < authority_end && data[host_begin] == '[') {
+		// IPv6 literal, the port follows the closing bracket
+		auto bracket = static_cast<const char *>(memchr(data + host_begin, ']', authority_end - host_begin));
+		if (bracket) {
+			host_end = bracket - data + 1;
+		}
+	} else {
+		auto colon = static_cast<const char *>(memchr(data + host_begin, ':', authority_end - host_begin));
+		if (colon) {
+			host_end = colon - data;
+		}
+	}
+	result.host_begin = host_begin;
+	result.host_end = host_end;
+	if (host_end < authority_end && data[host_end] == ':') {
+		result.port_begin = host_end + 1;
+		result.port_end = authority_end;
+	} else {
+		result.port_begin = result.port_end = authority_end;
+	}
+
+	// path, then "?query" and "#fragment"
+	const auto end = data + size;
+	const auto path_end = FindQueryOrFragment(data + authority_end, end) - data;
+	result.path_begin = authority_end;
+	result.path_end = path_end;
+	idx_t fragment_start = path_end;
+	if (path_end < size && data[path_end] == '?') {
+		auto hash = static_cast<const char *>(memchr(data + path_end, '#', size - path_end));
+		fragment_start = hash ? hash - data : size;
+		result.query_begin = path_end + 1;
+		result.query_end = fragment_start;
+	} else {
+		result.query_begin = result.query_end = path_end;
+	}
+	if (fragment_start < size) {
+		result.fragment_begin = fragment_start + 1;
+	} else {
+		result.fragment_begin = size;
+	}
+	result.fragment_end = size;
+	return result;
+}
+
+static string_t TopLevelDomain(const URLComponents &url) {
+	auto host = url.Host();
+	const auto data = host.GetData();
+	for (idx_t i = host.GetSize(); i > 0; i--) {
+		if (data[i - 1] == '.') {
+			return url.Slice(url.host_begin + i, url.host_end);
+		}
+	}
+	return url.Slice(url.host_end, url.host_end);
+}
+
+static string_t DomainWithoutWWW(const URLComponents &url) {
+	auto host = url.Host();
+	if (host.GetSize() > 4 && memcmp(host.GetData(), "www.", 4) == 0) {
+		return url.Slice(url.host_begin + 4, url.host_end);
+	}
+	return host;
+}
+
+//! Value of the first "name=value" pair of the query string, empty if there is none
+static string_t ExtractURLParameter(const URLComponents &url, string_t name) {
+	const auto name_data = name.GetData();
+	const auto name_size = name.GetSize();
+	auto pos = url.data + url.query_begin;
+	const auto end = url.data + url.query_end;
+	while (pos < end) {
+		auto param_end = static_cast<const char *>(memchr(pos, '&', end - pos));
+		if (!param_end) {
+			param_end = end;
+		}
+		if (idx_t(param_end - pos) > name_size && pos[name_size] == '=' && memcmp(pos, name_data, name_size) == 0) {
+			return string_t(pos + name_size + 1, static_cast<uint32_t>(param_end - pos - name_size - 1));
+		}
+		pos = param_end + 1;
+	}
+	return url.Slice(url.query_end, url.query_end);
+}
+
+//! Applies a component extractor, the results are slices of the input strings so its string heap is shared
+template <string_t (*EXTRACT)(const URLComponents &)>
+static void URLComponentFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &input = args.data[0];
+	UnaryExecutor::Execute<string_t, string_t>(input, result, args.size(),
+											   [&](string_t url) { return EXTRACT(SplitURL(url)); });
+	StringVector::AddHeapReference(result, input);
+}
+
+static string_t ProtocolOf(const URLComponents &url) {
+	return url.Protocol();
+}
+static string_t HostOf(const URLComponents &url) {
+	return url.Host();
+}
+static string_t PathOf(const URLComponents &url) {
+	return url.Path();
+}
+static string_t QueryOf(const URLComponents &url) {
+	return url.Query();
+}
+
+static void ExtractURLParameterFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &input = args.data[0];
+	BinaryExecutor::Execute<string_t, string_t, string_t>(
+	    input, args.data[1], result, args.size(),
+	    [&](string_t url, string_t name) { return ExtractURLParameter(SplitURL(url), name); });
+	StringVector::AddHeapReference(result, input);
+}
+
+static void CutQueryStringFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &input = args.data[0];
+	UnaryExecutor::Execute<string_t, string_t>(input, result, args.size(), [&](string_t url) {
+		auto parts = SplitURL(url);
+		if (parts.path_end == url.GetSize() || url.GetData()[parts.path_end] != '?') {
+			return url;
+		}
+		const auto fragment_size = url.GetSize() - parts.query_end;
+		if (fragment_size == 0) {
+			return parts.Slice(0, parts.path_end);
+		}
+		// "#fragment" survives, which means the two pieces have to be glued together
+		auto cut = StringVector::EmptyString(result, parts.path_end + fragment_size);
+		auto cut_data = cut.GetDataWriteable();
+		memcpy(cut_data, url.GetData(), parts.path_end);
+		memcpy(cut_data + parts.path_end, url.GetData() + parts.query_end, fragment_size);
+		cut.Finalize();
+		return cut;
+	});
+	StringVector::AddHeapReference(result, input);
+}
+
+static void ParseURLFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &input = args.data[0];
+	BinaryExecutor::ExecuteWithNulls<string_t, string_t, string_t>(
+	    input, args.data[1], result, args.size(), [&](string_t url, string_t part, ValidityMask &mask, idx_t idx) {
+		    auto parts = SplitURL(url);
+		    auto name = part.GetString();
+		    if (name == "protocol") {
+			    return parts.Protocol();
+		    } else if (name == "domain") {
+			    return parts.Host();
+		    } else if (name == "port") {
+			    return parts.Port();
+		    } else if (name == "path") {
+			    return parts.Path();
+		    } else if (name == "query") {
+			    return parts.Query();
+		    } else if (name == "fragment") {
+			    return parts.Fragment();
+		    }
+		    mask.SetInvalid(idx);
+		    return part;
+	    });
+	StringVector::AddHeapReference(result, input);
+}
+
+static void RegisterURLComponent(DatabaseInstance &instance, const string &name, scalar_function_t function) {
+	ExtensionUtil::RegisterFunction(instance,
+									ScalarFunction(name, {LogicalType::VARCHAR}, LogicalType::VARCHAR, function));
+}
+
+void RegisterURLFunctions(DatabaseInstance &instance) {
+	RegisterURLComponent(instance, "protocol", URLComponentFunction<ProtocolOf>);
+	RegisterURLComponent(instance, "domain", URLComponentFunction<HostOf>);
+	RegisterURLComponent(instance, "domainWithoutWWW", URLComponentFunction<DomainWithoutWWW>);
+	RegisterURLComponent(instance, "topLevelDomain", URLComponentFunction<TopLevelDomain>);
+	RegisterURLComponent(instance, "path", URLComponentFunction<PathOf>);
+	RegisterURLComponent(instance, "queryString", URLComponentFunction<QueryOf>);
+	RegisterURLComponent(instance, "cutQueryString", CutQueryStringFunction);
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("extractURLParameter",
+															 {LogicalType::VARCHAR, LogicalType::VARCHAR},
+															 LogicalType::VARCHAR, ExtractURLParameterFunction));
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("parseURL", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+															 LogicalType::VARCHAR, ParseURLFunction));
+}
+
+} // namespace duckdb
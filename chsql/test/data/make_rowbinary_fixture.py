@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+# Writes rowbinary_fixture.bin, a canned ClickHouse RowBinaryWithNamesAndTypes response used by chsql.test.
+# It is what `SELECT ... FORMAT RowBinaryWithNamesAndTypes` returns for the columns below.
+import os
+import struct
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def string(value):
+    data = value.encode()
+    return varint(len(data)) + data
+
+
+COLUMNS = [
+    ("id", "UInt32"),
+    ("name", "String"),
+    ("score", "Nullable(Float64)"),
+    ("day", "Date"),
+    ("ts", "DateTime64(3)"),
+    ("tags", "Array(LowCardinality(String))"),
+    ("kind", "Enum8('a' = 1, 'b' = 2)"),
+    ("uid", "UUID"),
+    ("amount", "Decimal(10, 2)"),
+]
+ROWS = 2500
+
+
+def row(i):
+    out = struct.pack("<I", i)
+    out += string("name%d" % i)
+    out += b"\x01" if i % 5 == 0 else b"\x00" + struct.pack("<d", i / 2)
+    out += struct.pack("<H", 19000 + i % 100)
+    out += struct.pack("<q", 1700000000000 + i * 1001)
+    out += varint(i % 3) + b"".join(string("t%d" % t) for t in range(i % 3))
+    out += struct.pack("<b", 1 + i % 2)
+    # UUID 00000000-0000-0001-0000-00000000xxxx: high 64 bits then low 64 bits, both little endian
+    out += struct.pack("<QQ", 1, i)
+    out += struct.pack("<q", i * 125)
+    return out
+
+
+def main():
+    data = varint(len(COLUMNS))
+    data += b"".join(string(name) for name, _ in COLUMNS)
+    data += b"".join(string(type_name) for _, type_name in COLUMNS)
+    data += b"".join(row(i) for i in range(ROWS))
+    with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), "rowbinary_fixture.bin"), "wb") as f:
+        f.write(data)
+
+
+if __name__ == "__main__":
+    main()
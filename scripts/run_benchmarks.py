@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Runs the chsql benchmarks with DuckDB's benchmark runner and writes the timings as JSON.
+
+The runner only discovers benchmarks below the benchmark/ directory of the DuckDB tree, so
+chsql/benchmark is linked there as benchmark/chsql before running. Build the runner with
+
+    make bench-build
+
+Every benchmark is reported with its individual run timings in seconds and their median:
+
+    {"commit": "...", "timestamp": "...", "benchmarks": [{"name": "...", "timings": [...], "median": ...}]}
+"""
+
+import argparse
+import datetime
+import json
+import os
+import statistics
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "HEAD"], cwd=ROOT, text=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def link_benchmarks(duckdb_dir):
+    link = os.path.join(duckdb_dir, "benchmark", "chsql")
+    if not os.path.lexists(link):
+        os.symlink(os.path.join(ROOT, "chsql", "benchmark"), link)
+
+
+def parse_timings(output):
+    """Parses the runner's "name<TAB>run<TAB>timing" lines, skipping the header and failed runs"""
+    results = {}
+    for line in output.splitlines():
+        fields = line.split("\t")
+        if len(fields) != 3 or not fields[1].isdigit():
+            continue
+        try:
+            timing = float(fields[2])
+        except ValueError:
+            continue
+        results.setdefault(fields[0], []).append(timing)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--duckdb", default=os.path.join(ROOT, "duckdb"), help="DuckDB source tree")
+    parser.add_argument("--runner", default=os.path.join(ROOT, "build", "release", "benchmark", "benchmark_runner"))
+    parser.add_argument("--pattern", default="benchmark/chsql/.*", help="regex selecting the benchmarks to run")
+    parser.add_argument("--out", help="JSON output file, stdout when omitted")
+    args = parser.parse_args()
+
+    link_benchmarks(args.duckdb)
+    run = subprocess.run([os.path.abspath(args.runner), args.pattern], cwd=args.duckdb, stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE, text=True)
+    sys.stderr.write(run.stderr)
+    timings = parse_timings(run.stdout)
+    report = {
+        "commit": git_commit(),
+        "timestamp": datetime.datetime.now(datetime.timezone.utc).isoformat(),
+        "benchmarks": [{"name": name, "timings": runs, "median": statistics.median(runs)}
+                       for name, runs in sorted(timings.items())],
+    }
+    text = json.dumps(report, indent=2)
+    if args.out:
+        with open(args.out, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+    if run.returncode != 0:
+        sys.stderr.write("benchmark runner failed with exit code %d\n" % run.returncode)
+    return run.returncode
+
+
+if __name__ == "__main__":
+    sys.exit(main())